@@ -9,6 +9,7 @@
 #include <iostream>
 #include <chrono>
 #include <vector>
+#include <cstring>
 
 using namespace std::chrono;
 
@@ -27,14 +28,14 @@ void benchmark_evaluation(Board& board, std::vector<BenchmarkResult>& results) {
     
     // Warmup
     for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        volatile int eval = NNUE::evaluate_incremental(*acc, board.get_current_turn());
+        volatile int eval = NNUE::evaluate_incremental(*acc, board.get_current_turn(), NNUE::output_bucket(board));
         (void)eval;
     }
     
     // Benchmark incremental evaluation
     auto start = high_resolution_clock::now();
     for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
-        volatile int eval = NNUE::evaluate_incremental(*acc, board.get_current_turn());
+        volatile int eval = NNUE::evaluate_incremental(*acc, board.get_current_turn(), NNUE::output_bucket(board));
         (void)eval;
     }
     auto end = high_resolution_clock::now();
@@ -118,10 +119,158 @@ void benchmark_accumulator_refresh(Board& board, std::vector<BenchmarkResult>& r
     });
 }
 
+void benchmark_cached_refresh(Board& board, std::vector<BenchmarkResult>& results) {
+    // Refresh through the refresh table, alternating with the position after a move like a king move would
+    NNUE::Accumulator acc;
+    NNUE::RefreshTable table;
+    MoveList moves;
+    board.generate_moves(moves);
+    Board child = board;
+    child.make_move(moves[0]);
+    const Board* boards[2] = {&board, &child};
+    
+    // Warmup
+    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+        NNUE::refresh_accumulator(acc, *boards[i & 1], 0, table);
+        NNUE::refresh_accumulator(acc, *boards[i & 1], 1, table);
+    }
+    
+    // Benchmark refresh of both perspectives
+    auto start = high_resolution_clock::now();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        NNUE::refresh_accumulator(acc, *boards[i & 1], 0, table);
+        NNUE::refresh_accumulator(acc, *boards[i & 1], 1, table);
+    }
+    auto end = high_resolution_clock::now();
+    auto duration = duration_cast<nanoseconds>(end - start).count();
+    
+    results.push_back({
+        "Accumulator Refresh (refresh table, one move apart)",
+        static_cast<double>(duration) / BENCHMARK_ITERATIONS,
+        BENCHMARK_ITERATIONS
+    });
+}
+
+// Time a kernel over BENCHMARK_ITERATIONS calls, returning average ns per call
+template<typename F>
+double time_kernel(F f) {
+    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+        f(i);
+    }
+    auto start = high_resolution_clock::now();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        f(i);
+    }
+    auto end = high_resolution_clock::now();
+    return static_cast<double>(duration_cast<nanoseconds>(end - start).count()) / BENCHMARK_ITERATIONS;
+}
+
+void benchmark_kernels(const Board& board) {
+    using namespace NNUE;
+
+    // Active feature indices of the position, used to drive the add/sub/refresh kernels
+    std::vector<int> features;
+    for (int square = 0; square < 64; square++) {
+        unsigned int piece = board.find_piece_occupying_sq(square);
+        if (piece == PIECE_NONE || piece == PIECE_EXTRA) {
+            continue;
+        }
+        int color = board.is_white_piece(square) ? 0 : 1;
+        features.push_back(((7 - piece) + 6 * color) * 64 + square);
+    }
+
+    Accumulator acc;
+    refresh_accumulator(acc, board);
+    volatile int32_t sink = 0;
+
+    auto refresh_with = [&](void (*add)(int16_t*, const int16_t*)) {
+        return [&, add](int) {
+            std::memcpy(acc.white_hidden, network.l0_bias, sizeof(acc.white_hidden));
+            for (int f : features) {
+                add(acc.white_hidden, &network.l0_weights[f * HIDDEN_SIZE]);
+            }
+            sink = acc.white_hidden[0];
+        };
+    };
+
+    struct KernelResult {
+        std::string name;
+        double scalar_ns;
+        double simd_ns;
+    };
+    std::vector<KernelResult> results;
+
+    // Add and sub alternate on the same feature so the accumulator stays in range
+    results.push_back({"add_feature",
+        time_kernel([&](int i) { Kernels::Scalar::add_feature(acc.black_hidden, &network.l0_weights[features[i % features.size()] * HIDDEN_SIZE]); }),
+        time_kernel([&](int i) { Kernels::add_feature(acc.black_hidden, &network.l0_weights[features[i % features.size()] * HIDDEN_SIZE]); })});
+    results.push_back({"sub_feature",
+        time_kernel([&](int i) { Kernels::Scalar::sub_feature(acc.black_hidden, &network.l0_weights[features[i % features.size()] * HIDDEN_SIZE]); }),
+        time_kernel([&](int i) { Kernels::sub_feature(acc.black_hidden, &network.l0_weights[features[i % features.size()] * HIDDEN_SIZE]); })});
+    results.push_back({"refresh (one perspective)",
+        time_kernel(refresh_with(Kernels::Scalar::add_feature)),
+        time_kernel(refresh_with(Kernels::add_feature))});
+
+    // The same refresh in one pass over the accumulator
+    std::vector<const int16_t*> rows;
+    for (int f : features) {
+        rows.push_back(&network.l0_weights[f * HIDDEN_SIZE]);
+    }
+    results.push_back({"add_sub_features (refresh, one perspective)",
+        time_kernel([&](int) {
+            Kernels::Scalar::add_sub_features(network.l0_bias, acc.white_hidden, rows.data(), rows.size(), nullptr, 0);
+            sink = acc.white_hidden[0];
+        }),
+        time_kernel([&](int) {
+            Kernels::add_sub_features(network.l0_bias, acc.white_hidden, rows.data(), rows.size(), nullptr, 0);
+            sink = acc.white_hidden[0];
+        })});
+
+    // Fused parent -> child updates, using the first few features of the position as weight rows
+    Accumulator child;
+    auto row = [&](int i) { return &network.l0_weights[features[i % features.size()] * HIDDEN_SIZE]; };
+    refresh_accumulator(acc, board);
+    results.push_back({"add1sub1 (quiet move)",
+        time_kernel([&](int i) { Kernels::Scalar::add1sub1(acc.white_hidden, child.white_hidden, row(i), row(i + 1)); sink = child.white_hidden[0]; }),
+        time_kernel([&](int i) { Kernels::add1sub1(acc.white_hidden, child.white_hidden, row(i), row(i + 1)); sink = child.white_hidden[0]; })});
+    results.push_back({"add1sub2 (capture)",
+        time_kernel([&](int i) { Kernels::Scalar::add1sub2(acc.white_hidden, child.white_hidden, row(i), row(i + 1), row(i + 2)); sink = child.white_hidden[0]; }),
+        time_kernel([&](int i) { Kernels::add1sub2(acc.white_hidden, child.white_hidden, row(i), row(i + 1), row(i + 2)); sink = child.white_hidden[0]; })});
+    results.push_back({"add2sub2 (castling)",
+        time_kernel([&](int i) { Kernels::Scalar::add2sub2(acc.white_hidden, child.white_hidden, row(i), row(i + 1), row(i + 2), row(i + 3)); sink = child.white_hidden[0]; }),
+        time_kernel([&](int i) { Kernels::add2sub2(acc.white_hidden, child.white_hidden, row(i), row(i + 1), row(i + 2), row(i + 3)); sink = child.white_hidden[0]; })});
+
+    // Fused against copying the parent and applying each feature separately, both with the active kernels
+    double separate_ns = time_kernel([&](int i) {
+        std::memcpy(child.white_hidden, acc.white_hidden, sizeof(child.white_hidden));
+        Kernels::add_feature(child.white_hidden, row(i));
+        Kernels::sub_feature(child.white_hidden, row(i + 1));
+        sink = child.white_hidden[0];
+    });
+    double fused_ns = time_kernel([&](int i) {
+        Kernels::add1sub1(acc.white_hidden, child.white_hidden, row(i), row(i + 1));
+        sink = child.white_hidden[0];
+    });
+
+    refresh_accumulator(acc, board);
+    results.push_back({"screlu_dot (output layer)",
+        time_kernel([&](int) { sink = Kernels::Scalar::screlu_dot(acc.white_hidden, acc.black_hidden, network.l1_weights); }),
+        time_kernel([&](int) { sink = Kernels::screlu_dot(acc.white_hidden, acc.black_hidden, network.l1_weights); })});
+
+    std::cout << "Kernel speedups (" << Kernels::simd_name << " vs scalar):" << std::endl;
+    for (const auto& result : results) {
+        std::cout << "  " << result.name << ": scalar " << result.scalar_ns << " ns, "
+                  << Kernels::simd_name << " " << result.simd_ns << " ns, speedup "
+                  << result.scalar_ns / result.simd_ns << "x" << std::endl;
+    }
+    std::cout << "  add1sub1 fused vs copy+add+sub: " << fused_ns << " ns vs " << separate_ns << " ns, speedup "
+              << separate_ns / fused_ns << "x" << std::endl;
+    std::cout << std::endl;
+}
+
 int main() {
     // Initialize
     init_eval_utils();
-    init_bitboard_utils();
     
     std::string nnue_path = "NNUE/checkpoints/tuna-100/quantised.bin";
     if (!NNUE::init(nnue_path)) {
@@ -157,6 +306,7 @@ int main() {
         benchmark_evaluation(board, results);
         benchmark_accumulator_update(board, results);
         benchmark_accumulator_refresh(board, results);
+        benchmark_cached_refresh(board, results);
         
         // Print results
         for (const auto& result : results) {
@@ -169,6 +319,8 @@ int main() {
             std::cout << "  Throughput: " << ops_per_sec << " ops/sec" << std::endl;
             std::cout << std::endl;
         }
+
+        benchmark_kernels(board);
         
         std::cout << std::endl;
     }
@@ -176,6 +328,7 @@ int main() {
     // System info
     std::cout << "=== System Information ===" << std::endl;
     std::cout << "Compiler: " << __VERSION__ << std::endl;
+    std::cout << "NNUE kernels: " << NNUE::Kernels::simd_name << std::endl;
     #ifdef __AVX2__
         std::cout << "AVX2: Enabled" << std::endl;
     #else
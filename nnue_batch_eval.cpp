@@ -0,0 +1,145 @@
+//
+//  nnue_batch_eval.cpp
+//  Score positions with the NNUE network at full speed
+//
+//  Positions are evaluated one at a time through NNUE::evaluate_positions; the only work shared between
+//  them is the refresh table, and the batches below only group the reading and writing of lines
+//
+//  Reads one position per line from stdin and writes its evaluation (centipawns, from the side to move's
+//  perspective) on its own line to stdout, in the same order
+//  A line's FEN ends at the first '|' (the test_data format), and the move counters may be left out (EPD)
+//  Blank lines and lines starting with '#' are skipped, unreadable positions are reported on stderr and skipped
+//
+//  Usage: nnue_batch_eval [network.bin] < positions.txt > evals.txt
+//
+
+#include "src/Board.hpp"
+#include "src/NNUE.hpp"
+#include "src/Evaluation.hpp"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <string>
+
+using namespace std::chrono;
+
+// Positions read before they're evaluated and their lines written out
+// Every board sets up an accumulator stack, so the batch is kept small
+const int BATCH_SIZE = 64;
+
+// Turn a line into a FEN read_FEN accepts, returns false if it doesn't hold one
+bool line_to_fen(const std::string& line, std::string& fen) {
+    // Split on whitespace up to the first '|'
+    size_t end = std::min(line.find('|'), line.size());
+    size_t field_start[6], field_end[6];
+    int num_fields = 0;
+    for (size_t i = 0; i < end && num_fields < 6;) {
+        while (i < end && isspace(line[i])) {
+            i++;
+        }
+        if (i == end) {
+            break;
+        }
+        field_start[num_fields] = i;
+        while (i < end && !isspace(line[i])) {
+            i++;
+        }
+        field_end[num_fields++] = i;
+    }
+    if (num_fields < 4) {
+        return false;
+    }
+    // read_FEN wants exactly one space between fields
+    bool has_counters = num_fields == 6 && isdigit(line[field_start[4]]) && isdigit(line[field_start[5]]);
+    fen.clear();
+    for (int i = 0; i < (has_counters ? 6 : 4); i++) {
+        fen.append(line, field_start[i], field_end[i] - field_start[i]);
+        fen += ' ';
+    }
+    if (!has_counters) {
+        // EPD: no counters, maybe operations instead
+        fen += "0 1";
+    } else {
+        fen.pop_back();
+    }
+    return true;
+}
+
+void flush_batch(const std::vector<Board>& boards, int count, std::vector<int>& evals, NNUE::RefreshTable& table,
+                 std::string& out, std::ostream& eval_out) {
+    NNUE::evaluate_positions(boards.data(), count, evals.data(), table);
+    out.clear();
+    for (int i = 0; i < count; i++) {
+        out += std::to_string(evals[i]);
+        out += '\n';
+    }
+    eval_out.write(out.data(), out.size());
+}
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(false);
+
+    // Stdout only gets the evaluations, whatever the engine reports on std::cout (loading the network,
+    // read_FEN errors) goes to stderr
+    std::ostream eval_out(std::cout.rdbuf(std::cerr.rdbuf()));
+    init_eval_utils();
+    bool loaded = argc > 1 ? NNUE::load_network(argv[1]) : NNUE::is_loaded();
+    if (!loaded) {
+        std::cerr << "Failed to load NNUE network!" << std::endl;
+        return 1;
+    }
+
+    std::vector<Board> boards(BATCH_SIZE);
+
+    NNUE::RefreshTable table;
+    std::vector<int> evals(BATCH_SIZE);
+    std::string line, fen, out;
+    int count = 0;
+    long long line_number = 0, num_positions = 0, num_skipped = 0;
+    auto start = high_resolution_clock::now();
+
+    while (std::getline(std::cin, line)) {
+        line_number++;
+        if (line.empty() || line[0] == '#' || line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        bool valid = line_to_fen(line, fen);
+        if (valid) {
+            try {
+                boards[count].read_FEN(fen);
+            } catch (const std::exception&) {
+                valid = false;
+            }
+        }
+        // Both kings are needed to pick the king buckets
+        if (valid && (pop_count(boards[count].get_bitboard(Kings) & boards[count].get_bitboard(WhitePieces)) != 1 ||
+                      pop_count(boards[count].get_bitboard(Kings) & boards[count].get_bitboard(BlackPieces)) != 1)) {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << "Skipping line " << line_number << ", not a position: " << line << std::endl;
+            num_skipped++;
+            continue;
+        }
+
+        if (++count == BATCH_SIZE) {
+            flush_batch(boards, count, evals, table, out, eval_out);
+            num_positions += count;
+            count = 0;
+        }
+    }
+    flush_batch(boards, count, evals, table, out, eval_out);
+    num_positions += count;
+    eval_out.flush();
+
+    double seconds = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1e9;
+    std::cerr << "Evaluated " << num_positions << " positions in " << seconds << " s ("
+              << static_cast<long long>(num_positions / std::max(seconds, 1e-9)) << " positions/s)";
+    if (num_skipped) {
+        std::cerr << ", skipped " << num_skipped << " lines";
+    }
+    std::cerr << std::endl;
+
+    return 0;
+}
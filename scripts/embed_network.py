@@ -8,63 +8,71 @@ import struct
 import sys
 import os
 
+INPUT_SIZE = 768
+HIDDEN_SIZE = 128
+
+# Input layouts the engine knows (NNUE::INPUT_LAYOUTS), by number of king buckets
+# They're told apart by the size of the file, so keep this in sync with NNUE.cpp
+INPUT_LAYOUTS = {
+    1: "Chess768",
+    4: "Chess768 x4 king buckets, mirrored",
+}
+
+# Output bucket counts the engine knows (NNUE::OUTPUT_BUCKET_COUNTS), picked by material
+OUTPUT_BUCKET_COUNTS = (1, 8)
+
+def network_bytes(num_king_buckets, num_output_buckets):
+    """Size of a network without the padding bullet adds to reach a multiple of 64 bytes."""
+    # Network structure (all int16_t):
+    # - l0_weights: num_king_buckets * 768 * 128 values
+    # - l0_bias: 128 values
+    # - l1_weights: num_output_buckets * 256 values
+    # - l1_bias: num_output_buckets values
+    return (num_king_buckets * INPUT_SIZE * HIDDEN_SIZE + HIDDEN_SIZE
+            + num_output_buckets * (2 * HIDDEN_SIZE + 1)) * 2
+
+def detect_layout(size):
+    """Return the numbers of king and output buckets of a network file of the given size, or None."""
+    for num_king_buckets in INPUT_LAYOUTS:
+        for num_output_buckets in OUTPUT_BUCKET_COUNTS:
+            expected = network_bytes(num_king_buckets, num_output_buckets)
+            if expected <= size <= (expected + 63) // 64 * 64:
+                return num_king_buckets, num_output_buckets
+    return None
+
 def read_network(filepath):
-    """Read quantized network binary file and return weights."""
+    """Read quantized network binary file and return its raw int16 values and king and output bucket counts."""
     with open(filepath, 'rb') as f:
         data = f.read()
-    
-    # Network structure (all int16_t):
-    # - l0_weights: 768 * 128 = 98304 values
-    # - l0_bias: 128 values
-    # - l1_weights: 256 values
-    # - l1_bias: 1 value
-    
-    INPUT_SIZE = 768
-    HIDDEN_SIZE = 128
-    
-    offset = 0
-    
-    # Read Layer 0 weights
-    l0_weights_count = INPUT_SIZE * HIDDEN_SIZE
-    l0_weights_size = l0_weights_count * 2  # 2 bytes per int16_t
-    l0_weights = struct.unpack(f'<{l0_weights_count}h', data[offset:offset + l0_weights_size])
-    offset += l0_weights_size
-    
-    # Read Layer 0 bias
-    l0_bias_count = HIDDEN_SIZE
-    l0_bias_size = l0_bias_count * 2
-    l0_bias = struct.unpack(f'<{l0_bias_count}h', data[offset:offset + l0_bias_size])
-    offset += l0_bias_size
-    
-    # Read Layer 1 weights
-    l1_weights_count = 2 * HIDDEN_SIZE
-    l1_weights_size = l1_weights_count * 2
-    l1_weights = struct.unpack(f'<{l1_weights_count}h', data[offset:offset + l1_weights_size])
-    offset += l1_weights_size
-    
-    # Read Layer 1 bias
-    l1_bias = struct.unpack('<h', data[offset:offset + 2])[0]
-    
-    return l0_weights, l0_bias, l1_weights, l1_bias
+
+    layout = detect_layout(len(data))
+    if layout is None:
+        print(f"Error: {filepath} ({len(data)} bytes) doesn't match any known network layout")
+        sys.exit(1)
+
+    # The engine binds the weights in place, so the file is embedded as is (padding included)
+    values = struct.unpack(f'<{len(data) // 2}h', data[:len(data) // 2 * 2])
+    return values, layout
 
 def format_array(name, data, values_per_line=16):
     """Format array data as C++ code."""
     lines = [f"alignas(64) const int16_t {name}[] = {{"]
-    
+
     for i in range(0, len(data), values_per_line):
         chunk = data[i:i + values_per_line]
         line = "    " + ", ".join(f"{val}" for val in chunk)
         if i + values_per_line < len(data):
             line += ","
         lines.append(line)
-    
+
     lines.append("};")
     return "\n".join(lines)
 
-def generate_header(l0_weights, l0_bias, l1_weights, l1_bias, output_path):
+def generate_header(values, layout, output_path):
     """Generate C++ header file with embedded network weights."""
-    
-    header = """//
+    num_king_buckets, num_output_buckets = layout
+
+    header = f"""//
 //  NNUE_embedded.hpp
 //  Tuna Chess Engine
 //
@@ -77,65 +85,53 @@ def generate_header(l0_weights, l0_bias, l1_weights, l1_bias, output_path):
 
 #include <cstdint>
 
-namespace NNUE {
-namespace Embedded {
-
-// Network architecture constants
-constexpr int INPUT_SIZE = 768;
-constexpr int HIDDEN_SIZE = 128;
+namespace NNUE {{
+namespace Embedded {{
 
-// Embedded network weights (quantized to int16_t)
+// Embedded network weights (quantized to int16_t), byte for byte the quantised.bin they came from
+// Layout: {INPUT_LAYOUTS[num_king_buckets]}, {num_output_buckets} output bucket(s)
+// The engine evaluates straight from this array, the layout is detected from its size like a network file's
 
 """
-    
-    # Add arrays
-    header += "// Layer 0 weights: 768 * 128 = 98304 values\n"
-    header += format_array("l0_weights", l0_weights, 16) + "\n\n"
-    
-    header += "// Layer 0 bias: 128 values\n"
-    header += format_array("l0_bias", l0_bias, 16) + "\n\n"
-    
-    header += "// Layer 1 weights: 256 values\n"
-    header += format_array("l1_weights", l1_weights, 16) + "\n\n"
-    
-    header += f"// Layer 1 bias: 1 value\n"
-    header += f"alignas(64) const int16_t l1_bias = {l1_bias};\n\n"
-    
+
+    header += format_array("data", values, 16) + "\n\n"
+
     header += """} // namespace Embedded
 } // namespace NNUE
 
 #endif /* NNUE_embedded_hpp */
 """
-    
+
     with open(output_path, 'w') as f:
         f.write(header)
-    
+
     print(f"Generated embedded network header: {output_path}")
-    print(f"  Layer 0 weights: {len(l0_weights)} values")
-    print(f"  Layer 0 bias: {len(l0_bias)} values")
-    print(f"  Layer 1 weights: {len(l1_weights)} values")
-    print(f"  Layer 1 bias: 1 value")
-    print(f"  Total size: ~{(len(l0_weights) + len(l0_bias) + len(l1_weights) + 1) * 2 / 1024:.1f} KB")
+    print(f"  Layout: {INPUT_LAYOUTS[num_king_buckets]}, {num_output_buckets} output bucket(s)")
+    print(f"  Layer 0 weights: {num_king_buckets * INPUT_SIZE * HIDDEN_SIZE} values")
+    print(f"  Layer 0 bias: {HIDDEN_SIZE} values")
+    print(f"  Layer 1 weights: {num_output_buckets * 2 * HIDDEN_SIZE} values")
+    print(f"  Layer 1 bias: {num_output_buckets} value(s)")
+    print(f"  Total size: ~{len(values) * 2 / 1024:.1f} KB")
 
 def main():
     if len(sys.argv) < 2:
         print("Usage: python3 embed_network.py <network.bin> [output.hpp]")
         print("Example: python3 embed_network.py NNUE/checkpoints/tuna-60/quantised.bin src/NNUE_embedded.hpp")
         sys.exit(1)
-    
+
     input_file = sys.argv[1]
     output_file = sys.argv[2] if len(sys.argv) >= 3 else "src/NNUE_embedded.hpp"
-    
+
     if not os.path.exists(input_file):
         print(f"Error: Input file not found: {input_file}")
         sys.exit(1)
-    
+
     print(f"Reading network from: {input_file}")
-    l0_weights, l0_bias, l1_weights, l1_bias = read_network(input_file)
-    
+    values, layout = read_network(input_file)
+
     print(f"Generating header file: {output_file}")
-    generate_header(l0_weights, l0_bias, l1_weights, l1_bias, output_file)
-    
+    generate_header(values, layout, output_file)
+
     print("Done!")
 
 if __name__ == "__main__":
@@ -13,26 +13,176 @@
 #include "Data_structs.hpp"
 #include "Utility.hpp"
 
-extern U64 rays[8][64];
-extern U64 king_paths[64];
-extern U64 knight_paths[64];
-extern U64 pawn_attacks[2][64];
-extern Directions direction_between[64][64];
-
-extern U64 rook_rays[64];
-extern U64 bishop_rays[64];
-
-U64 eastOne(U64 b);
-
-U64 noEaOne(U64 b);
-
-U64 soEaOne(U64 b);
-
-U64 westOne(U64 b);
-
-U64 soWeOne(U64 b);
-
-U64 noWeOne(U64 b);
+#include <array>
+
+constexpr U64 eastOne(U64 b) { return (b << 1) & ~a_file; }
+
+constexpr U64 noEaOne(U64 b) { return (b << 9) & ~a_file; }
+
+constexpr U64 soEaOne(U64 b) { return (b >> 7) & ~a_file; }
+
+constexpr U64 westOne(U64 b) { return (b >> 1) & ~h_file; }
+
+constexpr U64 soWeOne(U64 b) { return (b >> 9) & ~h_file; }
+
+constexpr U64 noWeOne(U64 b) { return (b << 7) & ~h_file; }
+
+// The tables below are computed by the compiler, so there's nothing to initialize at startup
+
+constexpr std::array<std::array<U64, 64>, 8> gen_rays() {
+    std::array<std::array<U64, 64>, 8> rays{};
+
+    U64 nort = C64(0x0101010101010100);
+    for (int sq = 0; sq < 64; sq++, nort <<= 1) {
+        rays[North][sq] = nort;
+    }
+
+    U64 noea = C64(0x8040201008040200);
+    for (int f = 0; f < 8; f++, noea = eastOne(noea)) {
+        U64 ne = noea;
+        for (int r8 = 0; r8 < 64; r8 += 8, ne <<= 8) {
+            rays[NorthEast][r8 + f] = ne;
+        }
+    }
+
+    U64 nowe = a8_h1_diagonal ^ (C64(1) << 7);
+    for (int f = 7; f >= 0; f--, nowe = westOne(nowe)) {
+        U64 nw = nowe;
+        for (int r8 = 0; r8 < 64; r8 += 8, nw <<= 8) {
+            rays[NorthWest][r8 + f] = nw;
+        }
+    }
+
+    U64 ea = first_rank ^ C64(1);
+    for (int f = 0; f < 8; f++, ea = eastOne(ea)) {
+        U64 ne = ea;
+        for (int r8 = 0; r8 < 64; r8 += 8, ne <<= 8) {
+            rays[East][r8 + f] = ne;
+        }
+    }
+
+    U64 sout = C64(0x0080808080808080);
+    for (int sq = 63; sq >= 0; sq--, sout >>= 1) {
+        rays[South][sq] = sout;
+    }
+
+    U64 soea = a8_h1_diagonal ^ (C64(1) << 56);
+    for (int f = 7; f >= 0; f--, soea = eastOne(soea)) {
+        U64 se = soea;
+        for (int r8 = 63; r8 >= 0; r8 -= 8, se >>= 8) {
+            rays[SouthEast][r8 - f] = se;
+        }
+    }
+
+    U64 sowe = a1_h8_diagonal ^ (C64(1) << 63);
+    for (int f = 0; f < 8; f++, sowe = westOne(sowe)) {
+        U64 sw = sowe;
+        for (int r8 = 63; r8 >= 0; r8 -= 8, sw >>= 8) {
+            rays[SouthWest][r8 - f] = sw;
+        }
+    }
+
+    U64 wes = first_rank ^ (C64(1) << 7);
+    for (int f = 7; f >= 0; f--, wes = westOne(wes)) {
+        U64 we = wes;
+        for (int r8 = 0; r8 < 64; r8 += 8, we <<= 8) {
+            rays[West][r8 + f] = we;
+        }
+    }
+    return rays;
+}
+
+inline constexpr std::array<std::array<U64, 64>, 8> rays = gen_rays();
+
+// Squares whose occupancy matters to a rook or bishop on each square: its rays without the board edges
+constexpr std::array<U64, 64> gen_rook_rays() {
+    std::array<U64, 64> rook_rays{};
+    for (int sq = 0; sq < 64; sq++) {
+        U64 r_rays = rays[North][sq] | rays[East][sq] | rays[South][sq] | rays[West][sq];
+        U64 sq_BB = C64(1) << sq;
+
+        U64 edge1 = sq_BB & a_file ? C64(0) : a_file;
+        U64 edge2 = sq_BB & h_file ? C64(0) : h_file;
+        U64 edge3 = sq_BB & first_rank ? C64(0) : first_rank;
+        U64 edge4 = sq_BB & eighth_rank ? C64(0) : eighth_rank;
+
+        r_rays &= ~(edge1 | edge2 | edge3 | edge4);
+
+        rook_rays[sq] = r_rays;
+    }
+    return rook_rays;
+}
+
+constexpr std::array<U64, 64> gen_bishop_rays() {
+    std::array<U64, 64> bishop_rays{};
+    for (int sq = 0; sq < 64; sq++) {
+        U64 b_rays = rays[NorthEast][sq] | rays[SouthEast][sq] | rays[SouthWest][sq] | rays[NorthWest][sq];
+        b_rays &= ~(a_file | h_file | first_rank | eighth_rank);
+        bishop_rays[sq] = b_rays;
+    }
+    return bishop_rays;
+}
+
+inline constexpr std::array<U64, 64> rook_rays = gen_rook_rays();
+inline constexpr std::array<U64, 64> bishop_rays = gen_bishop_rays();
+
+// Squares reached by stepping once by each of the num_steps (file, rank) offsets
+constexpr std::array<U64, 64> gen_step_paths(const int (*steps)[2], int num_steps) {
+    std::array<U64, 64> paths{};
+    for (int index = a1; index <= h8; index++) {
+        U64 mask = EmptyBoard;
+        for (int i = 0; i < num_steps; i++) {
+            int file = index % 8 + steps[i][0];
+            int rank = index / 8 + steps[i][1];
+            if (0 <= file && file <= 7 && 0 <= rank && rank <= 7) {
+                mask |= C64(1) << (rank * 8 + file);
+            }
+        }
+        paths[index] = mask;
+    }
+    return paths;
+}
+
+constexpr int king_steps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+constexpr int knight_steps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+
+inline constexpr std::array<U64, 64> king_paths = gen_step_paths(king_steps, 8);
+inline constexpr std::array<U64, 64> knight_paths = gen_step_paths(knight_steps, 8);
+
+constexpr std::array<std::array<U64, 64>, 2> gen_pawn_attacks() {
+    // 1st rank and 8th rank pawn attacks are actually essential
+    std::array<std::array<U64, 64>, 2> pawn_attacks{};
+    for (int index = a1; index <= h8; index++) {
+        pawn_attacks[WhitePieces][index] = noEaOne(C64(1) << index) | noWeOne(C64(1) << index);
+        pawn_attacks[BlackPieces][index] = soWeOne(C64(1) << index) | soEaOne(C64(1) << index);
+    }
+    return pawn_attacks;
+}
+
+inline constexpr std::array<std::array<U64, 64>, 2> pawn_attacks = gen_pawn_attacks();
+
+// Direction from one square towards another, by the signs of the file and rank differences
+// Only meaningful for squares on a common line, a square with itself gives North
+constexpr std::array<std::array<Directions, 64>, 64> gen_direction_between() {
+    constexpr Directions directions[3][3] = {
+        // Rank difference negative, zero, positive
+        {SouthWest, West, NorthWest}, // File difference negative
+        {South, North, North},        // Same file
+        {SouthEast, East, NorthEast}, // File difference positive
+    };
+    std::array<std::array<Directions, 64>, 64> direction_between{};
+    for (int from_index = a1; from_index <= h8; from_index++) {
+        for (int to_index = a1; to_index <= h8; to_index++) {
+            int d_file = to_index % 8 - from_index % 8;
+            int d_rank = to_index / 8 - from_index / 8;
+            direction_between[from_index][to_index] = directions[(d_file > 0) - (d_file < 0) + 1]
+                                                                [(d_rank > 0) - (d_rank < 0) + 1];
+        }
+    }
+    return direction_between;
+}
+
+inline constexpr std::array<std::array<Directions, 64>, 64> direction_between = gen_direction_between();
 
 int bitScan(U64 bb, bool reverse);
 
@@ -40,16 +190,4 @@ void print_BB(U64 b);
 
 void print_ls1bs(U64 x);
 
-void init_bitboard_utils();
-
-void init_king_paths();
-
-void init_knight_paths();
-
-void init_rays();
-
-void init_pawn_attacks();
-
-void init_direction_between();
-
 #endif /* Bitboard_hpp */
@@ -13,6 +13,8 @@ template void Board::generate_moves<ALL_MOVES>(MoveList &moves, bool &is_in_chec
 
 template void Board::generate_moves<CAPTURES_ONLY>(MoveList &moves, bool &is_in_check);
 
+template void Board::generate_moves<QUIETS_ONLY>(MoveList &moves, bool &is_in_check);
+
 template int Board::calculate_mobility<ALL_MOVES>(bool &is_in_check);
 
 template int Board::calculate_mobility<CAPTURES_ONLY>(bool &is_in_check);
@@ -21,6 +23,8 @@ template void Board::generate_moves<ALL_MOVES>(MoveList &moves);
 
 template void Board::generate_moves<CAPTURES_ONLY>(MoveList &moves);
 
+template void Board::generate_moves<QUIETS_ONLY>(MoveList &moves);
+
 template int Board::calculate_mobility<ALL_MOVES>();
 
 template int Board::calculate_mobility<CAPTURES_ONLY>();
@@ -44,11 +48,16 @@ Board::Board(std::string str) {
     standard_setup();
 }
 
+Board::~Board() = default;
+
 Board::Board(const Board& other) {
     // Copy all bitboards and state
     for (int i = 0; i < 8; i++) {
         Bitboards[i] = other.Bitboards[i];
     }
+    for (int sq = a1; sq <= h8; sq++) {
+        board[sq] = other.board[sq];
+    }
     current_turn = other.current_turn;
     white_can_castle_queenside = other.white_can_castle_queenside;
     white_can_castle_kingside = other.white_can_castle_kingside;
@@ -64,16 +73,11 @@ Board::Board(const Board& other) {
     piece_square_values_e[0] = other.piece_square_values_e[0];
     piece_square_values_e[1] = other.piece_square_values_e[1];
     
-    // Deep copy the accumulator if it exists
-    if (other.nnue_accumulator) {
-        nnue_accumulator = std::make_unique<NNUE::Accumulator>(*other.nnue_accumulator);
-    } else {
-        nnue_accumulator = nullptr;
-    }
-    
     move_stack = other.move_stack;
     reg_starting_pos = other.reg_starting_pos;
     z_key = other.z_key;
+
+    copy_nnue_accumulator(other);
 }
 
 Board& Board::operator=(const Board& other) {
@@ -82,6 +86,9 @@ Board& Board::operator=(const Board& other) {
         for (int i = 0; i < 8; i++) {
             Bitboards[i] = other.Bitboards[i];
         }
+        for (int sq = a1; sq <= h8; sq++) {
+            board[sq] = other.board[sq];
+        }
         current_turn = other.current_turn;
         white_can_castle_queenside = other.white_can_castle_queenside;
         white_can_castle_kingside = other.white_can_castle_kingside;
@@ -97,16 +104,11 @@ Board& Board::operator=(const Board& other) {
         piece_square_values_e[0] = other.piece_square_values_e[0];
         piece_square_values_e[1] = other.piece_square_values_e[1];
         
-        // Deep copy the accumulator if it exists
-        if (other.nnue_accumulator) {
-            nnue_accumulator = std::make_unique<NNUE::Accumulator>(*other.nnue_accumulator);
-        } else {
-            nnue_accumulator = nullptr;
-        }
-        
         move_stack = other.move_stack;
         reg_starting_pos = other.reg_starting_pos;
         z_key = other.z_key;
+
+        copy_nnue_accumulator(other);
     }
     return *this;
 }
@@ -229,6 +231,8 @@ void Board::read_FEN(std::string str) {
         }
     }
 
+    fill_mailbox();
+
     // Process counter strings
     halfmove_counter = std::stoi(halfmove_str);
     fullmove_counter = std::stoi(fullmove_str);
@@ -510,11 +514,13 @@ void Board::standard_setup() {
     move_stack.clear();
     
     // Initialize NNUE accumulator
+    nnue_stack.clear();
+    nnue_ply = 0;
+    nnue_base = 0;
     if (NNUE::USE_INCREMENTAL && NNUE::is_loaded()) {
-        nnue_accumulator = std::make_unique<NNUE::Accumulator>();
-        NNUE::refresh_accumulator(*nnue_accumulator, *this);
-    } else {
-        nnue_accumulator = nullptr;
+        nnue_stack.reserve(NNUE_STACK_RESERVE);
+        nnue_stack.emplace_back();
+        NNUE::refresh_accumulator(nnue_stack[0], *this);
     }
 }
 
@@ -629,38 +635,50 @@ bool Board::verify_bitboard() {
         print_board();
         return false;
     }
+    // Only called from asserts, so this costs nothing in release builds
+    for (int sq = a1; sq <= h8; sq++) {
+        U64 bit = C64(1) << sq;
+        unsigned int piece = PIECE_NONE;
+        for (int i = Kings; i <= Pawns; i++) {
+            if (Bitboards[i] & bit) {
+                piece = i;
+            }
+        }
+        if (piece != PIECE_NONE && (Bitboards[BlackPieces] & bit)) {
+            piece |= MAILBOX_BLACK;
+        }
+        if (board[sq] != piece) {
+            std::cout << "Mailbox has " << (int) board[sq] << " on square " << sq << ", bitboards have " << piece
+                      << '\n';
+            print_board();
+            return false;
+        }
+    }
     return true;
 }
 
+void Board::fill_mailbox() {
+    for (int sq = a1; sq <= h8; sq++) {
+        board[sq] = PIECE_NONE;
+    }
+    for (int i = Kings; i <= Pawns; i++) {
+        U64 pieces = Bitboards[i];
+        while (pieces) {
+            int sq = bitscan_forward(pieces);
+            board[sq] = i | ((Bitboards[BlackPieces] >> sq & 1) * MAILBOX_BLACK);
+            pieces &= pieces - 1;
+        }
+    }
+}
+
+
+U64 Board::get_bitboard(int index) const {
+    return Bitboards[index];
+}
 
 unsigned int Board::find_piece_occupying_sq(int index) const {
     // Finds what piece occupies a square
-    // This sort of lookup is inherently slow for bitboards
-
-    /*
-    // Branchless version
-    U64 bit = C64(1) << index;
-    return PIECE_QUEEN * ((Bitboards[Queens] & bit) != 0) + PIECE_ROOK * ((Bitboards[Rooks] & bit) != 0) + PIECE_BISHOP * ((Bitboards[Bishops] & bit) != 0) + PIECE_KNIGHT * ((Bitboards[Knights] & bit) != 0) + PIECE_PAWN * ((Bitboards[Pawns] & bit) != 0);
-    */
-
-    U64 bit = C64(1) << index;
-    if (!((Bitboards[WhitePieces] | Bitboards[BlackPieces]) & bit)) {
-        return PIECE_NONE;
-    } else if (Bitboards[Pawns] & bit) {
-        return PIECE_PAWN;
-    } else if (Bitboards[Knights] & bit) {
-        return PIECE_KNIGHT;
-    } else if (Bitboards[Bishops] & bit) {
-        return PIECE_BISHOP;
-    } else if (Bitboards[Rooks] & bit) {
-        return PIECE_ROOK;
-    } else if (Bitboards[Queens] & bit) {
-        return PIECE_QUEEN;
-    } else if (Bitboards[Kings] & bit) {
-        return PIECE_KING;
-    } else {
-        return PIECE_NONE;
-    }
+    return board[index] & ~MAILBOX_BLACK;
 }
 
 bool Board::is_white_piece(int index) const {
@@ -670,61 +688,20 @@ bool Board::is_white_piece(int index) const {
 }
 
 unsigned int Board::find_piece_captured(int index) {
-    // Similar routine to the above
+    // Finds what enemy piece occupies a square, PIECE_NONE if there isn't one
     // This function does not check if the capture is illegal, make sure to &~friendly_pieces beforehand.
     // Also, it doesn't check king captures
-
-    /*
-    U64 bit = C64(1) << index;
-    return PIECE_QUEEN * ((Bitboards[Queens] & bit) != 0) + PIECE_ROOK * ((Bitboards[Rooks] & bit) != 0) + PIECE_BISHOP * ((Bitboards[Bishops] & bit) != 0) + PIECE_KNIGHT * ((Bitboards[Knights] & bit) != 0) + PIECE_PAWN * ((Bitboards[Pawns] & bit) != 0);
-    */
-
-    U64 bit = C64(1) << index;
-    if (!(Bitboards[!current_turn] & bit)) {
-        return PIECE_NONE;
-    } else if (Bitboards[Pawns] & bit) {
-        return PIECE_PAWN;
-    } else if (Bitboards[Knights] & bit) {
-        return PIECE_KNIGHT;
-    } else if (Bitboards[Bishops] & bit) {
-        return PIECE_BISHOP;
-    } else if (Bitboards[Rooks] & bit) {
-        return PIECE_ROOK;
-    } else if (Bitboards[Queens] & bit) {
-        return PIECE_QUEEN;
-    // } else if (Bitboards[Kings] & bit) {
-        // return PIECE_KING;
-    } else {
-        return PIECE_NONE;
-    }
+    unsigned int piece = board[index] & ~MAILBOX_BLACK;
+    bool enemy = (board[index] & MAILBOX_BLACK) == (current_turn == WHITE ? MAILBOX_BLACK : 0);
+    return enemy && piece != PIECE_KING ? piece : PIECE_NONE;
 }
 
 unsigned int Board::find_piece_captured_without_occ(int index) {
     // Same as above, but assumes that at least some piece will be captured
     // This function does not check if the capture is illegal, make sure to &~friendly_pieces beforehand.
     // Also, it doesn't check king captures
-
-    /*
-    U64 bit = C64(1) << index;
-    return 2 * ((Bitboards[Queens] & bit) != 0) + 3 * ((Bitboards[Rooks] & bit) != 0) + 4 * ((Bitboards[Bishops] & bit) != 0) + 5 * ((Bitboards[Knights] & bit) != 0) + 6 * ((Bitboards[Pawns] & bit) != 0);
-     */
-
-    U64 bit = C64(1) << index;
-    if (Bitboards[Pawns] & bit) {
-        return PIECE_PAWN;
-    } else if (Bitboards[Knights] & bit) {
-        return PIECE_KNIGHT;
-    } else if (Bitboards[Bishops] & bit) {
-        return PIECE_BISHOP;
-    } else if (Bitboards[Rooks] & bit) {
-        return PIECE_ROOK;
-    } else if (Bitboards[Queens] & bit) {
-        return PIECE_QUEEN;
-    // } else if (Bitboards[Kings] & bit) {
-        // return PIECE_KING;
-    } else {
-        return PIECE_NONE;
-    }
+    unsigned int piece = board[index] & ~MAILBOX_BLACK;
+    return piece == PIECE_KING ? PIECE_NONE : piece;
 }
 
 
@@ -836,7 +813,7 @@ Board::generate_king_moves(MoveList &moves, U64 occ, U64 friendly_pieces, int ki
 
     int move_count = 0;
 
-    if (gen_type == ALL_MOVES) {
+    if (gen_type != CAPTURES_ONLY) {
         if (current_turn == WHITE) {
             if (white_can_castle_queenside && !num_attackers && !(C64(0xE) & occ) && !is_attacked(3, occ) &&
                 !is_attacked(2, occ)) {
@@ -883,6 +860,8 @@ Board::generate_king_moves(MoveList &moves, U64 occ, U64 friendly_pieces, int ki
     // If we only want captures, we'll intersect move_targets with the occupied squares
     if (gen_type == CAPTURES_ONLY) {
         move_targets &= occ;
+    } else if (gen_type == QUIETS_ONLY) {
+        move_targets &= ~occ;
     }
 
     // Given a rank in the chess board:
@@ -926,6 +905,9 @@ Board::generate_pawn_movesW(MoveList &moves, U64 block_check_masks, U64 occ, U64
         // East attacks:
         U64 east_attacks = ((pawns << 9) & ~a_file) & Bitboards[BlackPieces];
         east_attacks &= block_check_masks;
+        if (gen_type == QUIETS_ONLY) {
+            east_attacks = 0;
+        }
         // separate out promotions
         U64 east_promotion_attacks = east_attacks & eighth_rank;
         U64 east_regular_attacks = east_attacks & ~eighth_rank;
@@ -934,6 +916,9 @@ Board::generate_pawn_movesW(MoveList &moves, U64 block_check_masks, U64 occ, U64
         // West attacks:
         U64 west_attacks = ((pawns << 7) & ~h_file) & Bitboards[BlackPieces];
         west_attacks &= block_check_masks;
+        if (gen_type == QUIETS_ONLY) {
+            west_attacks = 0;
+        }
         U64 west_promotion_attacks = west_attacks & eighth_rank;
         U64 west_regular_attacks = west_attacks & ~eighth_rank;
 
@@ -979,7 +964,7 @@ Board::generate_pawn_movesW(MoveList &moves, U64 block_check_masks, U64 occ, U64
 
 
         // Quiet moves:
-        if (gen_type == ALL_MOVES) {
+        if (gen_type != CAPTURES_ONLY) {
 
             // Add Northern rook pins (only type of pin that pawn_push can move in)
             U64 north_and_south_of_king = rays[North][king_index] | rays[South][king_index];
@@ -1027,6 +1012,9 @@ Board::generate_pawn_movesW(MoveList &moves, U64 block_check_masks, U64 occ, U64
     // Pinned pawns are handled individually:
     U64 pinned_pawn_attacks =
             Bitboards[Pawns] & bishop_pinned; // No rook pinned since attacks can't happen when pinned by rook
+    if (gen_type == QUIETS_ONLY) {
+        pinned_pawn_attacks = 0;
+    }
 
     if (pinned_pawn_attacks)
         do {
@@ -1056,7 +1044,7 @@ Board::generate_pawn_movesW(MoveList &moves, U64 block_check_masks, U64 occ, U64
         } while (pinned_pawn_attacks &= pinned_pawn_attacks - 1);
 
     // En Passant:
-    if (en_passant_square != -1 && (((C64(1) << en_passant_square) & block_check_masks) ||
+    if (gen_type != QUIETS_ONLY && en_passant_square != -1 && (((C64(1) << en_passant_square) & block_check_masks) ||
                                     (C64(1) << (en_passant_square - 8) & block_check_masks))) {
         U64 en_passant_pawn_source = pawns & pawn_attacks[BlackPieces][en_passant_square];
 
@@ -1113,6 +1101,9 @@ Board::generate_pawn_movesB(MoveList &moves, U64 block_check_masks, U64 occ, U64
         // East attacks:
         U64 east_attacks = ((pawns >> 7) & ~a_file) & Bitboards[WhitePieces];
         east_attacks &= block_check_masks;
+        if (gen_type == QUIETS_ONLY) {
+            east_attacks = 0;
+        }
         // filter out promotions
         U64 east_promotion_attacks = east_attacks & first_rank;
         U64 east_regular_attacks = east_attacks & ~first_rank;
@@ -1121,6 +1112,9 @@ Board::generate_pawn_movesB(MoveList &moves, U64 block_check_masks, U64 occ, U64
         // West attacks:
         U64 west_attacks = ((pawns >> 9) & ~h_file) & Bitboards[WhitePieces];
         west_attacks &= block_check_masks;
+        if (gen_type == QUIETS_ONLY) {
+            west_attacks = 0;
+        }
         U64 west_promotion_attacks = west_attacks & first_rank;
         U64 west_regular_attacks = west_attacks & ~first_rank;
 
@@ -1165,7 +1159,7 @@ Board::generate_pawn_movesB(MoveList &moves, U64 block_check_masks, U64 occ, U64
 
 
         // Quiet moves:
-        if (gen_type == ALL_MOVES) {
+        if (gen_type != CAPTURES_ONLY) {
             // Add Southern rook pins (only type of pin that pawn_push can move in)
             U64 north_and_south_of_king = rays[North][king_index] | rays[South][king_index];
 
@@ -1208,6 +1202,9 @@ Board::generate_pawn_movesB(MoveList &moves, U64 block_check_masks, U64 occ, U64
     // Pinned pawns are handled individually:
     U64 pinned_pawn_attacks =
             Bitboards[Pawns] & bishop_pinned; // No rook pinned since attacks can't happen when pinned by rook
+    if (gen_type == QUIETS_ONLY) {
+        pinned_pawn_attacks = 0;
+    }
 
     if (pinned_pawn_attacks)
         do {
@@ -1238,7 +1235,7 @@ Board::generate_pawn_movesB(MoveList &moves, U64 block_check_masks, U64 occ, U64
         } while (pinned_pawn_attacks &= pinned_pawn_attacks - 1);
 
     // En Passant:
-    if (en_passant_square != -1 && (((C64(1) << en_passant_square) & block_check_masks) ||
+    if (gen_type != QUIETS_ONLY && en_passant_square != -1 && (((C64(1) << en_passant_square) & block_check_masks) ||
                                     (C64(1) << (en_passant_square + 8) & block_check_masks))) {
         U64 en_passant_pawn_source = pawns & pawn_attacks[WhitePieces][en_passant_square];
 
@@ -1314,6 +1311,8 @@ Board::generate_knight_moves(MoveList &moves, U64 block_check_masks, U64 occ, U6
 
             if (gen_type == CAPTURES_ONLY) {
                 move_targets &= occ;
+            } else if (gen_type == QUIETS_ONLY) {
+                move_targets &= ~occ;
             }
 
             if (serialize_type == SERIALIZE_MOVES) {
@@ -1355,6 +1354,8 @@ Board::generate_bishop_moves(MoveList &moves, U64 block_check_masks, U64 occ, U6
 
             if (gen_type == CAPTURES_ONLY) {
                 move_targets &= occ;
+            } else if (gen_type == QUIETS_ONLY) {
+                move_targets &= ~occ;
             }
 
             if (serialize_type == SERIALIZE_MOVES) {
@@ -1381,6 +1382,8 @@ Board::generate_bishop_moves(MoveList &moves, U64 block_check_masks, U64 occ, U6
 
             if (gen_type == CAPTURES_ONLY) {
                 move_targets &= occ;
+            } else if (gen_type == QUIETS_ONLY) {
+                move_targets &= ~occ;
             }
 
             if (serialize_type == SERIALIZE_MOVES) {
@@ -1420,6 +1423,8 @@ Board::generate_rook_moves(MoveList &moves, U64 block_check_masks, U64 occ, U64
 
             if (gen_type == CAPTURES_ONLY) {
                 move_targets &= occ;
+            } else if (gen_type == QUIETS_ONLY) {
+                move_targets &= ~occ;
             }
 
             if (serialize_type == SERIALIZE_MOVES) {
@@ -1445,6 +1450,8 @@ Board::generate_rook_moves(MoveList &moves, U64 block_check_masks, U64 occ, U64
 
             if (gen_type == CAPTURES_ONLY) {
                 move_targets &= occ;
+            } else if (gen_type == QUIETS_ONLY) {
+                move_targets &= ~occ;
             }
 
             if (serialize_type == SERIALIZE_MOVES) {
@@ -1483,6 +1490,8 @@ Board::generate_queen_moves(MoveList &moves, U64 block_check_masks, U64 occ, U64
 
             if (gen_type == CAPTURES_ONLY) {
                 move_targets &= occ;
+            } else if (gen_type == QUIETS_ONLY) {
+                move_targets &= ~occ;
             }
 
             if (serialize_type == SERIALIZE_MOVES) {
@@ -1509,6 +1518,8 @@ Board::generate_queen_moves(MoveList &moves, U64 block_check_masks, U64 occ, U64
 
             if (gen_type == CAPTURES_ONLY) {
                 move_targets &= occ;
+            } else if (gen_type == QUIETS_ONLY) {
+                move_targets &= ~occ;
             }
 
             if (serialize_type == SERIALIZE_MOVES) {
@@ -1628,12 +1639,112 @@ bool Board::is_in_check() {
                        Bitboards[WhitePieces] | Bitboards[BlackPieces]);
 }
 
+bool Board::is_legal_move(Move move) {
+    // Validates a move that didn't come from the generator for this position (hash move, killers)
+    // without generating the full move list. The move has to match exactly what the generator would
+    // have produced, including the moved and captured pieces, since make_move trusts those fields.
+    int from_index = move.get_from();
+    int to_index = move.get_to();
+    U64 from_bb = C64(1) << from_index;
+    U64 to_bb = C64(1) << to_index;
+    U64 friendly_pieces = Bitboards[current_turn];
+    U64 occ = Bitboards[WhitePieces] | Bitboards[BlackPieces];
+    unsigned int piece_moved = move.get_piece_moved();
+    unsigned int flag = move.get_special_flag();
+
+    if (!(friendly_pieces & from_bb) || (friendly_pieces & to_bb) || from_index == to_index ||
+        find_piece_occupying_sq(from_index) != piece_moved) {
+        return false;
+    }
+
+    // Castling, en passant and check evasions are rare enough to just be checked against the generator
+    if (flag == MOVE_CASTLING || flag == MOVE_ENPASSANT || is_in_check()) {
+        MoveList moves;
+        generate_moves(moves);
+        for (auto it = moves.begin(); it != moves.end(); ++it) {
+            if (((it->get_raw_data() ^ move.get_raw_data()) & 0x3FFFFF) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (move.get_piece_captured() != find_piece_captured(to_index) || (Bitboards[Kings] & to_bb)) {
+        return false;
+    }
+
+    U64 targets;
+    switch (piece_moved) {
+        case PIECE_PAWN: {
+            int forward = current_turn == WHITE ? 8 : -8;
+            U64 last_rank = current_turn == WHITE ? eighth_rank : first_rank;
+            if (to_index == from_index + forward) {
+                targets = to_bb & ~occ;
+            } else if (to_index == from_index + 2 * forward) {
+                bool on_start_rank = current_turn == WHITE ? from_index < 16 : from_index >= 48;
+                targets = on_start_rank && !(occ & ((C64(1) << (from_index + forward)) | to_bb)) ? to_bb : 0;
+            } else {
+                targets = pawn_attacks[current_turn][from_index] & Bitboards[!current_turn];
+            }
+            if ((flag == MOVE_PROMOTION) != ((to_bb & last_rank) != 0)) {
+                return false;
+            }
+            break;
+        }
+        case PIECE_KNIGHT:
+            targets = knight_paths[from_index];
+            break;
+        case PIECE_BISHOP:
+            targets = bishop_attacks(from_index, occ);
+            break;
+        case PIECE_ROOK:
+            targets = rook_attacks(from_index, occ);
+            break;
+        case PIECE_QUEEN:
+            targets = bishop_attacks(from_index, occ) | rook_attacks(from_index, occ);
+            break;
+        case PIECE_KING:
+            targets = king_paths[from_index];
+            break;
+        default:
+            return false;
+    }
+
+    if (!(targets & to_bb) || (piece_moved != PIECE_PAWN && flag != MOVE_NORMAL)) {
+        return false;
+    }
+
+    if (piece_moved == PIECE_KING) {
+        return !is_attacked(to_index, occ ^ from_bb);
+    }
+
+    // We aren't in check, so the move can only be illegal by uncovering a slider attack on our king
+    int king_index = bitscan_forward(Bitboards[Kings] & friendly_pieces);
+    U64 new_occ = (occ ^ from_bb) | to_bb;
+    U64 enemy_pieces = Bitboards[!current_turn] & ~to_bb;
+    return !((bishop_attacks(king_index, new_occ) & (Bitboards[Bishops] | Bitboards[Queens]) & enemy_pieces) ||
+             (rook_attacks(king_index, new_occ) & (Bitboards[Rooks] | Bitboards[Queens]) & enemy_pieces));
+}
+
+Move Board::complete_move(Move move) {
+    // Fills in the moved and captured pieces of a move that only has its squares and flags (e.g. from the TT)
+    // The result still has to be checked with is_legal_move
+    move.set_piece_moved(find_piece_occupying_sq(move.get_from()));
+    move.set_piece_captured(move.get_special_flag() == MOVE_ENPASSANT ? PIECE_PAWN : find_piece_captured(move.get_to()));
+    return move;
+}
+
 
 void Board::make_move(Move move) {
     move_data m = {move, white_can_castle_queenside, white_can_castle_kingside, black_can_castle_queenside,
                    black_can_castle_kingside, en_passant_square, z_key, false, halfmove_counter};
     move_stack.push_back(m);
-    
+
+    // NNUE: Push the child accumulator, it's computed from the dirty pieces recorded below when needed
+    DirtyPieces& dirty = move_stack.back().dirty;
+    if (use_nnue_accumulator()) {
+        push_nnue_accumulator();
+    }
 
 
     // Actual act of making move:
@@ -1659,8 +1770,8 @@ void Board::make_move(Move move) {
         z_key ^= piece_bitstrings[move_to_index][!current_turn][move.get_piece_captured() -
                                                                 2]; // Must -2 because pieces start at third index, not first
         // NNUE: Remove captured piece
-        if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-            NNUE::remove_piece_from_accumulator(*nnue_accumulator, move.get_piece_captured(), move_to_index, !current_turn);
+        if (use_nnue_accumulator()) {
+            dirty.remove(move.get_piece_captured(), move_to_index, !current_turn);
         } else {
             // Take away piece square value for captured piece
             piece_square_values_m[!current_turn] -= lookup_ps_table_m(move_to_index, move.get_piece_captured(),
@@ -1676,6 +1787,9 @@ void Board::make_move(Move move) {
     // Flip the occupacy of the from square and to square
     Bitboards[current_turn] ^= from_bb | to_bb;
     Bitboards[move.get_piece_moved()] ^= from_bb | to_bb;
+    // The moved piece overwrites any captured piece in the mailbox
+    board[move_from_index] = PIECE_NONE;
+    board[move_to_index] = move.get_piece_moved() | (current_turn * MAILBOX_BLACK);
 
     // Update zobrist keys
     z_key ^= piece_bitstrings[move_from_index][current_turn][move.get_piece_moved() - 2];
@@ -1684,9 +1798,9 @@ void Board::make_move(Move move) {
 
 
     // NNUE: Remove piece from old square
-    if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-        NNUE::remove_piece_from_accumulator(*nnue_accumulator, move.get_piece_moved(), move_from_index, current_turn);
-        NNUE::add_piece_to_accumulator(*nnue_accumulator, move.get_piece_moved(), move_to_index, current_turn);
+    if (use_nnue_accumulator()) {
+        dirty.remove(move.get_piece_moved(), move_from_index, current_turn);
+        dirty.add(move.get_piece_moved(), move_to_index, current_turn);
     } else {
         piece_square_values_m[current_turn] -= lookup_ps_table_m(move_from_index, move.get_piece_moved(), current_turn);
         piece_square_values_e[current_turn] -= lookup_ps_table_e(move_from_index, move.get_piece_moved(), current_turn);
@@ -1718,15 +1832,17 @@ void Board::make_move(Move move) {
             rook_bits = (C64(1) << rook_from_index) | (C64(1) << rook_to_index);
             Bitboards[current_turn] ^= rook_bits;
             Bitboards[Rooks] ^= rook_bits;
+            board[rook_from_index] = PIECE_NONE;
+            board[rook_to_index] = PIECE_ROOK | (current_turn * MAILBOX_BLACK);
 
             // Update zobrist key
             z_key ^= piece_bitstrings[rook_from_index][current_turn][PIECE_ROOK - 2];
             z_key ^= piece_bitstrings[rook_to_index][current_turn][PIECE_ROOK - 2];
 
             // NNUE: Remove rook from old square
-            if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-                NNUE::remove_piece_from_accumulator(*nnue_accumulator, PIECE_ROOK, rook_from_index, current_turn);
-                NNUE::add_piece_to_accumulator(*nnue_accumulator, PIECE_ROOK, rook_to_index, current_turn);
+            if (use_nnue_accumulator()) {
+                dirty.remove(PIECE_ROOK, rook_from_index, current_turn);
+                dirty.add(PIECE_ROOK, rook_to_index, current_turn);
             } else {
                 piece_square_values_m[current_turn] -= lookup_ps_table_m(rook_from_index, PIECE_ROOK, current_turn);
                 piece_square_values_e[current_turn] -= lookup_ps_table_e(rook_from_index, PIECE_ROOK, current_turn);
@@ -1749,6 +1865,7 @@ void Board::make_move(Move move) {
             }
             Bitboards[!current_turn] ^= delete_square;
             Bitboards[Pawns] ^= delete_square;
+            board[delete_index] = PIECE_NONE;
 
             // Take away the piece values for the side that pieces were captured
             piece_values[!current_turn] -= piece_to_value[PIECE_PAWN];
@@ -1761,8 +1878,8 @@ void Board::make_move(Move move) {
 
 
             // NNUE: Remove en passant captured pawn
-            if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-                NNUE::remove_piece_from_accumulator(*nnue_accumulator, PIECE_PAWN, delete_index, !current_turn);
+            if (use_nnue_accumulator()) {
+                dirty.remove(PIECE_PAWN, delete_index, !current_turn);
             } else {
                 // Take away piece square value for captured piece
                 piece_square_values_m[!current_turn] -= lookup_ps_table_m(delete_index, PIECE_PAWN, !current_turn);
@@ -1774,6 +1891,7 @@ void Board::make_move(Move move) {
         case MOVE_PROMOTION: {
             Bitboards[Pawns] ^= to_bb;
             Bitboards[move.get_promote_to() + 3] ^= to_bb;
+            board[move_to_index] = (move.get_promote_to() + 3) | (current_turn * MAILBOX_BLACK);
 
             // Change the piece_values score accordingly
             piece_values[current_turn] += piece_to_value[move.get_promote_to() + 3] - PAWN_VALUE;
@@ -1788,9 +1906,8 @@ void Board::make_move(Move move) {
                                                                    1]; // Check move encoding to see why +1
 
             // NNUE: Add promoted piece
-            if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-                NNUE::remove_piece_from_accumulator(*nnue_accumulator, PIECE_PAWN, move_to_index, current_turn);
-                NNUE::add_piece_to_accumulator(*nnue_accumulator, move.get_promote_to() + 3, move_to_index, current_turn);
+            if (use_nnue_accumulator()) {
+                dirty.promote(move.get_promote_to() + 3);
             } else {
                 // Take away piece square value for captured piece
                 piece_square_values_m[current_turn] -= lookup_ps_table_m(move_to_index, PIECE_PAWN, current_turn);
@@ -1926,13 +2043,6 @@ void Board::make_move(Move move) {
     // Increment halfmove counter
     halfmove_counter++;
     
-    // FIXME: There's a bug in the incremental NNUE update for pawn moves.
-    // As a workaround, refresh the accumulator from scratch after any pawn move.
-    // This ensures correctness but sacrifices some performance.
-    // if (move.get_piece_moved() == PIECE_PAWN && NNUE::is_loaded() && nnue_accumulator) {
-        // NNUE::refresh_accumulator(*nnue_accumulator, *this);
-    // }
-
     assert(verify_bitboard());
 
 }
@@ -1976,10 +2086,7 @@ void Board::unmake_move() {
         // Update piece_count
 //        piece_count[!current_turn][move.get_piece_captured() - 2] += 1;
 
-        // NNUE: Add captured piece back
-        if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-            NNUE::add_piece_to_accumulator(*nnue_accumulator, move.get_piece_captured(), move_to_index, !current_turn);
-        } else {
+        if (!use_nnue_accumulator()) {
             piece_square_values_m[!current_turn] += lookup_ps_table_m(move_to_index, move.get_piece_captured(),
                                                                       !current_turn);
             piece_square_values_e[!current_turn] += lookup_ps_table_e(move_to_index, move.get_piece_captured(),
@@ -1992,12 +2099,15 @@ void Board::unmake_move() {
     // Flip the occupacy of the from square and to square
     Bitboards[current_turn] ^= from_bb | to_bb;
     Bitboards[move.get_piece_moved()] ^= from_bb | to_bb;
-
-    // NNUE: Remove piece from destination square, add back to source square
-    if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-        NNUE::remove_piece_from_accumulator(*nnue_accumulator, move.get_piece_moved(), move_to_index, current_turn);
-        NNUE::add_piece_to_accumulator(*nnue_accumulator, move.get_piece_moved(), move_from_index, current_turn);
+    // For promotions the piece moved is the pawn, so this also takes back the promoted piece
+    board[move_from_index] = move.get_piece_moved() | (current_turn * MAILBOX_BLACK);
+    if (move.get_piece_captured() != PIECE_NONE && move.get_special_flag() != MOVE_ENPASSANT) {
+        board[move_to_index] = move.get_piece_captured() | (!current_turn * MAILBOX_BLACK);
     } else {
+        board[move_to_index] = PIECE_NONE;
+    }
+
+    if (!use_nnue_accumulator()) {
         piece_square_values_m[current_turn] += lookup_ps_table_m(move_from_index, move.get_piece_moved(), current_turn);
         piece_square_values_e[current_turn] += lookup_ps_table_e(move_from_index, move.get_piece_moved(), current_turn);
 
@@ -2030,12 +2140,10 @@ void Board::unmake_move() {
             rook_bits = (C64(1) << rook_from_index) | (C64(1) << rook_to_index);
             Bitboards[current_turn] ^= rook_bits;
             Bitboards[Rooks] ^= rook_bits;
+            board[rook_from_index] = PIECE_ROOK | (current_turn * MAILBOX_BLACK);
+            board[rook_to_index] = PIECE_NONE;
 
-            // NNUE: Move rook back to original square
-            if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-                NNUE::remove_piece_from_accumulator(*nnue_accumulator, PIECE_ROOK, rook_to_index, current_turn);
-                NNUE::add_piece_to_accumulator(*nnue_accumulator, PIECE_ROOK, rook_from_index, current_turn);
-            } else {
+            if (!use_nnue_accumulator()) {
                 piece_square_values_m[current_turn] += lookup_ps_table_m(rook_from_index, PIECE_ROOK, current_turn);
                 piece_square_values_e[current_turn] += lookup_ps_table_e(rook_from_index, PIECE_ROOK, current_turn);
 
@@ -2057,6 +2165,7 @@ void Board::unmake_move() {
             }
             Bitboards[!current_turn] ^= delete_square;
             Bitboards[Pawns] ^= delete_square;
+            board[delete_index] = PIECE_PAWN | (!current_turn * MAILBOX_BLACK);
 
             // Add back the piece values for the captured pawn
             piece_values[!current_turn] += piece_to_value[PIECE_PAWN];
@@ -2064,10 +2173,7 @@ void Board::unmake_move() {
             // Update piece_count
 //            piece_count[!current_turn][PIECE_PAWN - 2] += 1;
 
-            // NNUE: Add en passant captured pawn back
-            if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-                NNUE::add_piece_to_accumulator(*nnue_accumulator, PIECE_PAWN, delete_index, !current_turn);
-            } else {
+            if (!use_nnue_accumulator()) {
                 piece_square_values_m[!current_turn] += lookup_ps_table_m(delete_index, PIECE_PAWN, !current_turn);
                 piece_square_values_e[!current_turn] += lookup_ps_table_e(delete_index, PIECE_PAWN, !current_turn);
             }
@@ -2084,11 +2190,7 @@ void Board::unmake_move() {
 //            piece_count[current_turn][PIECE_PAWN - 2] += 1;
 //            piece_count[current_turn][move.get_promote_to() + 1] -= 1;
 
-            // NNUE: Remove promoted piece, add pawn back
-            if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-                NNUE::remove_piece_from_accumulator(*nnue_accumulator, move.get_promote_to() + 3, move_to_index, current_turn);
-                NNUE::add_piece_to_accumulator(*nnue_accumulator, PIECE_PAWN, move_to_index, current_turn);
-            } else {
+            if (!use_nnue_accumulator()) {
                 piece_square_values_m[current_turn] += lookup_ps_table_m(move_to_index, PIECE_PAWN, current_turn);
                 piece_square_values_e[current_turn] += lookup_ps_table_e(move_to_index, PIECE_PAWN, current_turn);
 
@@ -2103,6 +2205,11 @@ void Board::unmake_move() {
 
     move_stack.pop_back();
 
+    // NNUE: The parent accumulator is still on the stack below the current one
+    if (use_nnue_accumulator()) {
+        pop_nnue_accumulator();
+    }
+
     assert(verify_bitboard());
 }
 
@@ -2113,8 +2220,14 @@ void Board::make_null_move() {
     m.is_null_move = true;
     m.z_key = z_key;
     m.halfmove_counter = halfmove_counter;
+    m.dirty = DirtyPieces();
     move_stack.push_back(m);
 
+    // NNUE: A null move doesn't change any pieces, the child is just a copy of the parent
+    if (use_nnue_accumulator()) {
+        push_nnue_accumulator();
+    }
+
     // Reset en_passant_square and clear it from z_key
     if (en_passant_square != -1) {
         U64 last_en_passant_file = rays[South][en_passant_square];
@@ -2144,6 +2257,10 @@ void Board::unmake_null_move() {
 
     move_stack.pop_back();
 
+    if (use_nnue_accumulator()) {
+        pop_nnue_accumulator();
+    }
+
     // Should halfmove_counter be updated?
     halfmove_counter = last_move.halfmove_counter;
 
@@ -2328,9 +2445,10 @@ int Board::static_eval() {
     // Returns eval in terms of side to play
     
     // Try to use NNUE evaluation first
-    if (NNUE::USE_INCREMENTAL && NNUE::is_loaded() && nnue_accumulator) {
-        // Use incremental NNUE evaluation with pre-computed accumulator
-        return NNUE::evaluate_incremental(*nnue_accumulator, current_turn);
+    if (use_nnue_accumulator()) {
+        // Use incremental NNUE evaluation, catching up on any pending accumulator updates first
+        update_nnue_accumulator();
+        return NNUE::evaluate_incremental(nnue_stack[nnue_ply], current_turn, NNUE::output_bucket(*this));
     } else if (NNUE::is_loaded()) {
         // Fallback to non-incremental NNUE evaluation
         return NNUE::evaluate(*this);
@@ -2488,15 +2606,116 @@ bool Board::get_reg_starting_pos() {
     return reg_starting_pos;
 }
 
-NNUE::Accumulator* Board::get_nnue_accumulator() const {
-    return nnue_accumulator.get();
+NNUE::Accumulator* Board::get_nnue_accumulator() {
+    if (nnue_stack.empty()) {
+        return nullptr;
+    }
+    update_nnue_accumulator();
+    return &nnue_stack[nnue_ply];
 }
 
 void Board::refresh_nnue_accumulator() {
     if (NNUE::USE_INCREMENTAL && NNUE::is_loaded()) {
-        if (!nnue_accumulator) {
-            nnue_accumulator = std::make_unique<NNUE::Accumulator>();
+        if (nnue_stack.empty()) {
+            nnue_stack.reserve(NNUE_STACK_RESERVE);
+            nnue_stack.emplace_back();
+            nnue_ply = 0;
+            nnue_base = move_stack.size();
+        }
+        NNUE::refresh_accumulator(nnue_stack[nnue_ply], *this);
+    }
+}
+
+inline bool Board::use_nnue_accumulator() const {
+    return NNUE::USE_INCREMENTAL && NNUE::is_loaded() && !nnue_stack.empty();
+}
+
+void Board::copy_nnue_accumulator(const Board& other) {
+    // Only the current accumulator is copied; the copy starts its own stack from it
+    nnue_stack.clear();
+    nnue_ply = 0;
+    nnue_base = move_stack.size();
+    if (!other.nnue_stack.empty()) {
+        nnue_stack.reserve(NNUE_STACK_RESERVE);
+        nnue_stack.emplace_back();
+        const NNUE::Accumulator& other_acc = other.nnue_stack[other.nnue_ply];
+        if (other_acc.computed[WHITE] && other_acc.computed[BLACK]) {
+            nnue_stack[0] = other_acc;
+        } else {
+            // other is const so its pending updates can't be applied; compute ours from scratch
+            NNUE::refresh_accumulator(nnue_stack[0], *this);
+        }
+    }
+}
+
+void Board::push_nnue_accumulator() {
+    if (nnue_ply + 1 == nnue_stack.size()) {
+        nnue_stack.emplace_back();
+    }
+    nnue_ply++;
+    nnue_stack[nnue_ply].computed[WHITE] = false;
+    nnue_stack[nnue_ply].computed[BLACK] = false;
+}
+
+void Board::pop_nnue_accumulator() {
+    if (nnue_ply > 0) {
+        nnue_ply--;
+    } else {
+        // Unmaking past the position this board was copied from, so there is no parent to return to
+        nnue_base--;
+        NNUE::refresh_accumulator(nnue_stack[0], *this);
+    }
+}
+
+void Board::update_nnue_accumulator() {
+    if (nnue_stack[nnue_ply].computed[WHITE] && nnue_stack[nnue_ply].computed[BLACK]) {
+        return;
+    }
+
+    // Walk back to the nearest computed ancestor of each perspective; nnue_stack[0] is always computed
+    // If a side's king changed bucket on the way the ancestor uses other weights, so refresh instead
+    unsigned int start[2] = {nnue_ply + 1, nnue_ply + 1}; // First ply to replay
+    bool refresh[2] = {false, false};
+    for (int perspective = WHITE; perspective <= BLACK; perspective++) {
+        if (nnue_stack[nnue_ply].computed[perspective]) {
+            continue;
+        }
+        unsigned int ply = nnue_ply;
+        while (!refresh[perspective]) {
+            if (NNUE::needs_refresh(move_stack[nnue_base + ply - 1].dirty, perspective)) {
+                refresh[perspective] = true;
+            } else if (nnue_stack[ply - 1].computed[perspective]) {
+                break;
+            } else {
+                ply--;
+            }
+        }
+        start[perspective] = ply;
+    }
+
+    // Then replay the dirty pieces of each move from there
+    // The kings stayed in the same buckets all along, so their current squares pick the weights
+    int king_squares[2] = {bitscan_forward(Bitboards[Kings] & Bitboards[WHITE]),
+                           bitscan_forward(Bitboards[Kings] & Bitboards[BLACK])};
+    if (!refresh[WHITE] && !refresh[BLACK] && start[WHITE] == start[BLACK]) {
+        // Usual case, both perspectives are behind by the same moves
+        for (unsigned int ply = start[WHITE]; ply <= nnue_ply; ply++) {
+            NNUE::apply_dirty_pieces(nnue_stack[ply - 1], nnue_stack[ply], move_stack[nnue_base + ply - 1].dirty,
+                                     king_squares);
+        }
+        return;
+    }
+    for (int perspective = WHITE; perspective <= BLACK; perspective++) {
+        if (refresh[perspective]) {
+            if (!nnue_refresh_table) {
+                nnue_refresh_table.reset(new NNUE::RefreshTable());
+            }
+            NNUE::refresh_accumulator(nnue_stack[nnue_ply], *this, perspective, *nnue_refresh_table);
+            continue;
+        }
+        for (unsigned int ply = start[perspective]; ply <= nnue_ply; ply++) {
+            NNUE::apply_dirty_pieces(nnue_stack[ply - 1], nnue_stack[ply], move_stack[nnue_base + ply - 1].dirty,
+                                     perspective, king_squares[perspective]);
         }
-        NNUE::refresh_accumulator(*nnue_accumulator, *this);
     }
 }
@@ -21,11 +21,24 @@
 #include "NNUE.hpp"
 #include <memory>
 
+// Initial capacity of the NNUE accumulator stack, enough for a full search without reallocating
+#define NNUE_STACK_RESERVE 256
+
+// Color bit of a mailbox entry, set for black pieces (piece types fit in the bits below it)
+#define MAILBOX_BLACK 8
+
 class Board {
 private:
     // Handles board posititions:
     U64 Bitboards[8];
 
+    // Mailbox kept alongside the bitboards so finding what's on a square is a single load
+    // Each entry is the piece type, plus MAILBOX_BLACK for black pieces; PIECE_NONE for an empty square
+    uint8_t board[64];
+
+    // Rebuild board[] from the bitboards
+    void fill_mailbox();
+
 
     // 0 is white, 1 is black
     int current_turn;
@@ -50,8 +63,29 @@ private:
 
 //    int piece_count[2][6];
 
-    // NNUE accumulator for incremental updates
-    std::unique_ptr<NNUE::Accumulator> nnue_accumulator;
+    // NNUE accumulator stack for incremental updates, one entry per ply made on this board
+    // make_move only records the move's dirty pieces in move_data and pushes an uncomputed entry;
+    // the accumulator is brought up to date from the nearest computed ancestor when it's evaluated
+    // unmake_move just steps back down
+    // nnue_stack[nnue_ply] is the accumulator of the current position; the stack is empty if NNUE is off
+    std::vector<NNUE::Accumulator> nnue_stack;
+    unsigned int nnue_ply;
+    // Index in move_stack of the move leading to nnue_stack[1]
+    unsigned int nnue_base;
+    // Accumulators cached per king bucket for refreshes, made on first use and never copied between boards
+    std::unique_ptr<NNUE::RefreshTable> nnue_refresh_table;
+
+    // Incremental NNUE is in use for this board (otherwise piece square values are tracked instead)
+    bool use_nnue_accumulator() const;
+
+    void copy_nnue_accumulator(const Board& other);
+
+    void push_nnue_accumulator();
+
+    void pop_nnue_accumulator();
+
+    // Apply pending dirty pieces so nnue_stack[nnue_ply] is computed
+    void update_nnue_accumulator();
 
     std::vector<move_data> move_stack;
 
@@ -65,6 +99,8 @@ public:
     Board(std::string str);
     
     Board(const Board& other);
+
+    ~Board();
     
     Board& operator=(const Board& other);
 
@@ -87,6 +123,9 @@ public:
     bool verify_bitboard();
 
     unsigned int find_piece_occupying_sq(int index) const;
+
+    // Bitboards[index], indexed by Enum_BoardBB (colors, then piece types)
+    U64 get_bitboard(int index) const;
     
     bool is_white_piece(int index) const;
 
@@ -152,6 +191,10 @@ public:
 
     bool is_in_check();
 
+    bool is_legal_move(Move move);
+
+    Move complete_move(Move move);
+
     // Move generation end
 
 
@@ -211,7 +254,7 @@ public:
     bool get_reg_starting_pos();
     
     // NNUE accumulator access
-    NNUE::Accumulator* get_nnue_accumulator() const;
+    NNUE::Accumulator* get_nnue_accumulator();
     void refresh_nnue_accumulator();
 
     void serialize_promotion(MoveList &moves, int from_index, int to_index, unsigned int piece_captured) const;
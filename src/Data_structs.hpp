@@ -48,7 +48,8 @@ enum Directions {
 
 enum MoveGenType {
     ALL_MOVES,
-    CAPTURES_ONLY,
+    CAPTURES_ONLY, // Captures, capturing promotions and en passant
+    QUIETS_ONLY,   // Everything else: quiet moves, push promotions and castling
 };
 
 enum SerializationType {
@@ -197,11 +198,44 @@ public:
 bool move_cmp(Move first, Move second);
 
 
-// Forward declaration for NNUE::Accumulator
+// Forward declarations for NNUE::Accumulator and NNUE::RefreshTable
 namespace NNUE {
     struct Accumulator;
+    struct RefreshTable;
 }
 
+// A piece placed on or taken off a square by a move, as seen by the NNUE accumulator
+struct DirtyPiece {
+    uint8_t piece;
+    uint8_t square;
+    uint8_t color;
+};
+
+// Accumulator delta of a move, applied lazily when the position is evaluated
+// At most 2 pieces are added (castling) and 2 removed (castling, captures with promotion or en passant)
+struct DirtyPieces {
+    uint8_t num_added;
+    uint8_t num_removed;
+    DirtyPiece added[2];
+    DirtyPiece removed[2];
+
+    void add(unsigned int piece, unsigned int square, unsigned int color) {
+        assert(num_added < 2);
+        added[num_added++] = DirtyPiece{(uint8_t) piece, (uint8_t) square, (uint8_t) color};
+    }
+
+    void remove(unsigned int piece, unsigned int square, unsigned int color) {
+        assert(num_removed < 2);
+        removed[num_removed++] = DirtyPiece{(uint8_t) piece, (uint8_t) square, (uint8_t) color};
+    }
+
+    // The pawn just added on the promotion square becomes the promoted piece
+    void promote(unsigned int piece) {
+        assert(num_added > 0);
+        added[num_added - 1].piece = (uint8_t) piece;
+    }
+};
+
 struct move_data {
     Move move;
 
@@ -217,6 +251,8 @@ struct move_data {
     bool is_null_move;
 
     int halfmove_counter;
+
+    DirtyPieces dirty;
 };
 
 
@@ -10,14 +10,36 @@
 
 
 Engine::Engine(Thread::SafeQueue<std::vector<std::string>>& c, std::atomic<bool>& b) : cmd_queue(c),
-                                                                                       should_end_search(b) {};
+                                                                                       should_end_search(b),
+                                                                                       num_threads(1),
+                                                                                       eval_caches(1),
+                                                                                       perft_hash_mb(PERFT_TT_DEFAULT_MB) {};
+
+static std::string tt_info(const TT& tt) {
+    std::ostringstream buffer;
+    size_t page_size = tt.get_page_size();
+    buffer << tt.size_mb() << " MB, ";
+    if (page_size >= (1 << 20)) {
+        buffer << (page_size >> 20) << " MB pages";
+    } else {
+        buffer << (page_size >> 10) << " KB pages";
+    }
+    if (tt.get_huge_pages_requested()) {
+        buffer << ", transparent huge pages requested";
+    }
+    return buffer.str();
+}
 
 void Engine::loop() {
     Board board;
     TT tt;
+    // Allocated by the first go perft, so it costs nothing unless perft is run
+    PerftTT perft_tt;
     OpeningBook opening_book;
     TimeHandler inf_time(should_end_search);
 
+    get_synced_cout().print("info string Hash " + tt_info(tt) + "\n");
+
     while (true) {
         std::vector<std::string> cmd = cmd_queue.dequeue();
 
@@ -26,39 +48,44 @@ void Engine::loop() {
                 return;
             } else if (cmd.at(0) == "go") {
                 if (cmd.at(1) == "perft") {
-                    int perft_depth = std::stoi(cmd.at(2));
+                    // Each root move gets a perft of depth - 1, so the depth must be at least 1
+                    int perft_depth = std::max(std::stoi(cmd.at(2)), 1);
 
                     MoveList moves;
                     board.generate_moves(moves);
 
-                    long perft_sum = 0;
+                    // Counts stay valid from one position to the next, so the table is only cleared by a resize
+                    if (perft_tt.size_mb() != perft_hash_mb) {
+                        perft_tt.resize(perft_hash_mb);
+                    }
 
                     auto t1 = std::chrono::high_resolution_clock::now();
 
-                    for (int i = 0; i < moves.size(); i++) {
-
-                        board.make_move(moves[i]);
-
-                        Search search(board, tt, opening_book, inf_time);
-                        long perft_score = search.perft(perft_depth - 1);
-                        perft_sum += perft_score;
-                        std::ostringstream buffer;
-                        buffer << move_to_str(moves[i], true) << ": ";
-                        buffer << perft_score << '\n';
-                        get_synced_cout().print(buffer.str());
-
-                        board.unmake_move();
+                    Search search(board, tt, opening_book, inf_time);
+                    search.set_threads(num_threads);
+                    std::vector<long> perft_scores = search.split_perft(moves, perft_depth,
+                                                                        perft_hash_mb ? &perft_tt : nullptr);
 
-                    }
                     auto t2 = std::chrono::high_resolution_clock::now();
                     std::chrono::duration<double, std::milli> ms_double = t2 - t1;
+
+                    long perft_sum = 0;
                     std::ostringstream buffer;
+                    for (int i = 0; i < moves.size(); i++) {
+                        perft_sum += perft_scores[i];
+                        buffer << move_to_str(moves[i], true) << ": ";
+                        buffer << perft_scores[i] << '\n';
+                    }
                     buffer << "\nNodes Searched: " << perft_sum << '\n';
-                    buffer << "Time: " << ms_double.count() << "ms\n\n";
+                    buffer << "Time: " << ms_double.count() << "ms\n";
+                    buffer << "Nodes/second: " << (long) (perft_sum / std::max(ms_double.count() / 1000, 1e-9))
+                           << "\n\n";
                     get_synced_cout().print(buffer.str());
 
                 } else if (cmd.at(1) == "infinite") {
                     Search search(board, tt, opening_book, inf_time);
+                    search.set_threads(num_threads);
+                    search.set_eval_caches(eval_caches);
                     search.find_best_move(64);
                 } else {
                     int max_depth = 64;
@@ -104,6 +131,8 @@ void Engine::loop() {
 
                     TimeHandler time_handler(should_end_search, t_type, time_ms);
                     Search search(board, tt, opening_book, time_handler);
+                    search.set_threads(num_threads);
+                    search.set_eval_caches(eval_caches);
                     search.find_best_move(max_depth);
                 }
             } else if (cmd.at(0) == "position") {
@@ -135,6 +164,61 @@ void Engine::loop() {
                 buffer << "NNUE evaluation: " << eval << " centipawns";
                 buffer << " (from " << (board.get_current_turn() == WHITE ? "white" : "black") << "'s perspective)\n";
                 get_synced_cout().print(buffer.str());
+            } else if (cmd.at(0) == "setoption") {
+                // setoption name <id> [value <x>], where id may contain spaces
+                std::string name, value;
+                unsigned int i = 1;
+                if (cmd.at(i) == "name") {
+                    i++;
+                }
+                for (; i < cmd.size() && cmd[i] != "value"; i++) {
+                    name += (name.empty() ? "" : " ") + cmd[i];
+                }
+                if (i + 1 < cmd.size()) {
+                    value = cmd[i + 1];
+                }
+
+                if (name == "Hash") {
+                    tt.resize(std::stoul(value));
+                    std::ostringstream buffer;
+                    buffer << "info string Hash set to " << tt_info(tt) << '\n';
+                    get_synced_cout().print(buffer.str());
+                } else if (name == "PerftHash") {
+                    perft_hash_mb = std::min(std::stoul(value), (unsigned long) TT_MAX_MB);
+                } else if (name == "Threads") {
+                    num_threads = std::min(std::max(std::stoi(value), 1), MAX_SEARCH_THREADS);
+                    tt.set_threads(num_threads);
+                    eval_caches.resize(num_threads);
+                } else if (name == "EvalFile") {
+                    // The path may contain spaces too
+                    for (i += 2; i < cmd.size(); i++) {
+                        value += " " + cmd[i];
+                    }
+                    bool loaded = value.empty() || value == "<empty>" || value == "embedded" ?
+                                  NNUE::init_embedded() : NNUE::load_network(value);
+                    if (loaded) {
+                        // The accumulators were built from the old weights, and so were the eval caches and
+                        // the scores and static evals in the TT, which would otherwise feed the pruning margins
+                        board.refresh_nnue_accumulator();
+                        tt.clear();
+                        for (auto& cache : eval_caches) {
+                            cache.clear();
+                        }
+                    }
+                } else {
+                    std::cerr << "Unknown option: " << name << '\n';
+                }
+            } else if (cmd.at(0) == "savehash" || cmd.at(0) == "loadhash") {
+                // savehash <file> / loadhash <file>, where the path may contain spaces
+                std::string path = cmd.at(1);
+                for (unsigned int i = 2; i < cmd.size(); i++) {
+                    path += " " + cmd[i];
+                }
+                if (cmd[0] == "savehash" && tt.save(path)) {
+                    get_synced_cout().print("info string Hash saved to " + path + "\n");
+                } else if (cmd[0] == "loadhash" && tt.load(path)) {
+                    get_synced_cout().print("info string Hash loaded from " + path + ", " + tt_info(tt) + "\n");
+                }
             } else if (cmd.at(0) == "ucinewgame") {
                 board = Board();
                 tt.clear();
@@ -144,6 +228,9 @@ void Engine::loop() {
         catch (std::out_of_range& e) {
             std::cerr << "Insufficient parameters\n";
         }
+        catch (std::invalid_argument& e) {
+            std::cerr << "Invalid parameter\n";
+        }
     }
 }
 
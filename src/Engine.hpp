@@ -21,6 +21,15 @@ class Engine {
 private:
     Thread::SafeQueue<std::vector<std::string>>& cmd_queue;
     std::atomic<bool>& should_end_search;
+
+    // Number of Lazy SMP search threads (main thread included)
+    unsigned int num_threads;
+
+    // One eval cache per search thread, kept across searches so each one starts with the last one's evals
+    std::vector<EvalCache> eval_caches;
+
+    // Size of the table go perft shares between its threads, 0 for unhashed perft
+    size_t perft_hash_mb;
 public:
     Engine(Thread::SafeQueue<std::vector<std::string>>& c, std::atomic<bool>& b);
 
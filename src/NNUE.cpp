@@ -8,26 +8,415 @@
 #include "NNUE.hpp"
 #include "NNUE_embedded.hpp"
 #include "Board.hpp"
+#include "Thread.hpp"
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX512BW__) || defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
 
 namespace NNUE {
+    const InputLayout INPUT_LAYOUTS[] = {
+        // Plain Chess768, no king buckets
+        {"Chess768", 1, false, {0}},
+        // 4 king buckets, mirrored: back rank split in two, second rank, then everything further up
+        {"Chess768 x4 king buckets, mirrored", 4, true, {
+            0, 0, 1, 1, 1, 1, 0, 0,
+            2, 2, 2, 2, 2, 2, 2, 2,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3,
+        }},
+    };
+    const int NUM_INPUT_LAYOUTS = sizeof(INPUT_LAYOUTS) / sizeof(INPUT_LAYOUTS[0]);
+
     Network network;
     bool network_loaded = false;
+
+    // Mapping (or heap copy) backing the network loaded from a file, released when it's replaced
+    void* network_file_memory = nullptr;
+    size_t network_file_bytes_mapped = 0;
+
+    namespace Kernels {
+        namespace Scalar {
+            void add_feature(int16_t* acc, const int16_t* weights) {
+                for (int i = 0; i < HIDDEN_SIZE; i++) {
+                    acc[i] += weights[i];
+                }
+            }
+
+            void sub_feature(int16_t* acc, const int16_t* weights) {
+                for (int i = 0; i < HIDDEN_SIZE; i++) {
+                    acc[i] -= weights[i];
+                }
+            }
+
+            void add1sub1(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0) {
+                for (int i = 0; i < HIDDEN_SIZE; i++) {
+                    dst[i] = src[i] + a0[i] - s0[i];
+                }
+            }
+
+            void add1sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0, const int16_t* s1) {
+                for (int i = 0; i < HIDDEN_SIZE; i++) {
+                    dst[i] = src[i] + a0[i] - s0[i] - s1[i];
+                }
+            }
+
+            void add2sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* a1,
+                          const int16_t* s0, const int16_t* s1) {
+                for (int i = 0; i < HIDDEN_SIZE; i++) {
+                    dst[i] = src[i] + a0[i] + a1[i] - s0[i] - s1[i];
+                }
+            }
+
+            void add_sub_features(const int16_t* src, int16_t* dst, const int16_t* const* add, int num_added,
+                                  const int16_t* const* sub, int num_removed) {
+                std::memmove(dst, src, HIDDEN_SIZE * sizeof(int16_t));
+                for (int j = 0; j < num_added; j++) {
+                    add_feature(dst, add[j]);
+                }
+                for (int j = 0; j < num_removed; j++) {
+                    sub_feature(dst, sub[j]);
+                }
+            }
+
+            int32_t screlu_dot(const int16_t* stm, const int16_t* ntm, const int16_t* weights) {
+                int32_t output = 0;
+                for (int i = 0; i < HIDDEN_SIZE; i++) {
+                    output += screlu(stm[i]) * weights[i];
+                }
+                for (int i = 0; i < HIDDEN_SIZE; i++) {
+                    output += screlu(ntm[i]) * weights[HIDDEN_SIZE + i];
+                }
+                return output;
+            }
+        }
+
+        // Each instruction set defines vec_t with its int16 primitives and its own screlu_dot
+        // The add/sub kernels below are shared between them
+        // Loads and stores are unaligned: accumulators are cache line aligned, but the weights are read in place from
+        // the network file data, which has no alignment guarantee, and on aligned addresses unaligned loads cost nothing
+#if defined(__AVX512BW__)
+#define NNUE_USE_SIMD
+        const char* const simd_name = "AVX-512BW";
+
+        typedef __m512i vec_t;
+        constexpr int VEC_LANES = 32;
+
+        inline vec_t vec_load(const int16_t* p) { return _mm512_loadu_si512(p); }
+        inline void vec_store(int16_t* p, vec_t v) { _mm512_storeu_si512(p, v); }
+        inline vec_t vec_add16(vec_t a, vec_t b) { return _mm512_add_epi16(a, b); }
+        inline vec_t vec_sub16(vec_t a, vec_t b) { return _mm512_sub_epi16(a, b); }
+
+        // v = clamp(x, 0, QA), then madd(v * w, v) gives v^2 * w summed in pairs as int32
+        // v * w fits in int16 since QA * max |l1 weight| < 2^15
+        inline __m512i screlu_dot_half(__m512i sum, const int16_t* acc, const int16_t* weights) {
+            const __m512i zero = _mm512_setzero_si512();
+            const __m512i qa = _mm512_set1_epi16(QA);
+            for (int i = 0; i < HIDDEN_SIZE; i += 32) {
+                __m512i v = _mm512_loadu_si512(acc + i);
+                v = _mm512_min_epi16(_mm512_max_epi16(v, zero), qa);
+                __m512i w = _mm512_loadu_si512(weights + i);
+                sum = _mm512_add_epi32(sum, _mm512_madd_epi16(_mm512_mullo_epi16(v, w), v));
+            }
+            return sum;
+        }
+
+        int32_t screlu_dot(const int16_t* stm, const int16_t* ntm, const int16_t* weights) {
+            __m512i sum = _mm512_setzero_si512();
+            sum = screlu_dot_half(sum, stm, weights);
+            sum = screlu_dot_half(sum, ntm, weights + HIDDEN_SIZE);
+            return _mm512_reduce_add_epi32(sum);
+        }
+#elif defined(__AVX2__)
+#define NNUE_USE_SIMD
+        const char* const simd_name = "AVX2";
+
+        typedef __m256i vec_t;
+        constexpr int VEC_LANES = 16;
+
+        inline vec_t vec_load(const int16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        inline void vec_store(int16_t* p, vec_t v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+        inline vec_t vec_add16(vec_t a, vec_t b) { return _mm256_add_epi16(a, b); }
+        inline vec_t vec_sub16(vec_t a, vec_t b) { return _mm256_sub_epi16(a, b); }
+
+        // Same v * w, v trick as the AVX-512 version above
+        inline __m256i screlu_dot_half(__m256i sum, const int16_t* acc, const int16_t* weights) {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i qa = _mm256_set1_epi16(QA);
+            for (int i = 0; i < HIDDEN_SIZE; i += 16) {
+                __m256i v = vec_load(acc + i);
+                v = _mm256_min_epi16(_mm256_max_epi16(v, zero), qa);
+                __m256i w = vec_load(weights + i);
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_mullo_epi16(v, w), v));
+            }
+            return sum;
+        }
+
+        int32_t screlu_dot(const int16_t* stm, const int16_t* ntm, const int16_t* weights) {
+            __m256i sum = _mm256_setzero_si256();
+            sum = screlu_dot_half(sum, stm, weights);
+            sum = screlu_dot_half(sum, ntm, weights + HIDDEN_SIZE);
+
+            __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+            s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+            return _mm_cvtsi128_si32(s);
+        }
+#elif defined(__SSE4_1__)
+#define NNUE_USE_SIMD
+        const char* const simd_name = "SSE4.1";
+
+        typedef __m128i vec_t;
+        constexpr int VEC_LANES = 8;
+
+        inline vec_t vec_load(const int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        inline void vec_store(int16_t* p, vec_t v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+        inline vec_t vec_add16(vec_t a, vec_t b) { return _mm_add_epi16(a, b); }
+        inline vec_t vec_sub16(vec_t a, vec_t b) { return _mm_sub_epi16(a, b); }
+
+        // Same v * w, v trick as the AVX-512 version above
+        inline __m128i screlu_dot_half(__m128i sum, const int16_t* acc, const int16_t* weights) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i qa = _mm_set1_epi16(QA);
+            for (int i = 0; i < HIDDEN_SIZE; i += 8) {
+                __m128i v = vec_load(acc + i);
+                v = _mm_min_epi16(_mm_max_epi16(v, zero), qa);
+                __m128i w = vec_load(weights + i);
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_mullo_epi16(v, w), v));
+            }
+            return sum;
+        }
+
+        int32_t screlu_dot(const int16_t* stm, const int16_t* ntm, const int16_t* weights) {
+            __m128i sum = _mm_setzero_si128();
+            sum = screlu_dot_half(sum, stm, weights);
+            sum = screlu_dot_half(sum, ntm, weights + HIDDEN_SIZE);
+
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+            return _mm_cvtsi128_si32(sum);
+        }
+#endif
+
+#ifdef NNUE_USE_SIMD
+        static_assert(HIDDEN_SIZE % VEC_LANES == 0, "HIDDEN_SIZE must be a multiple of the SIMD lane count");
+
+        void add_feature(int16_t* acc, const int16_t* weights) {
+            for (int i = 0; i < HIDDEN_SIZE; i += VEC_LANES) {
+                vec_store(acc + i, vec_add16(vec_load(acc + i), vec_load(weights + i)));
+            }
+        }
+
+        void sub_feature(int16_t* acc, const int16_t* weights) {
+            for (int i = 0; i < HIDDEN_SIZE; i += VEC_LANES) {
+                vec_store(acc + i, vec_sub16(vec_load(acc + i), vec_load(weights + i)));
+            }
+        }
+
+        // The fused kernels read the parent and write the child in a single pass,
+        // instead of a copy followed by one load-modify-store pass per feature
+        void add1sub1(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0) {
+            for (int i = 0; i < HIDDEN_SIZE; i += VEC_LANES) {
+                vec_t v = vec_add16(vec_load(src + i), vec_load(a0 + i));
+                vec_store(dst + i, vec_sub16(v, vec_load(s0 + i)));
+            }
+        }
+
+        void add1sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0, const int16_t* s1) {
+            for (int i = 0; i < HIDDEN_SIZE; i += VEC_LANES) {
+                vec_t v = vec_add16(vec_load(src + i), vec_load(a0 + i));
+                v = vec_sub16(v, vec_load(s0 + i));
+                vec_store(dst + i, vec_sub16(v, vec_load(s1 + i)));
+            }
+        }
+
+        void add2sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* a1,
+                      const int16_t* s0, const int16_t* s1) {
+            for (int i = 0; i < HIDDEN_SIZE; i += VEC_LANES) {
+                vec_t v = vec_add16(vec_load(src + i), vec_load(a0 + i));
+                v = vec_add16(v, vec_load(a1 + i));
+                v = vec_sub16(v, vec_load(s0 + i));
+                vec_store(dst + i, vec_sub16(v, vec_load(s1 + i)));
+            }
+        }
+
+        // Registers per pass of add_sub_features: the whole accumulator with AVX-512 and AVX2,
+        // half of it with SSE, which leaves the other registers for the weight rows
+        constexpr int TILE_REGS = HIDDEN_SIZE / VEC_LANES < 8 ? HIDDEN_SIZE / VEC_LANES : 8;
+        static_assert(HIDDEN_SIZE % (TILE_REGS * VEC_LANES) == 0, "HIDDEN_SIZE must be a multiple of the tile size");
+
+        void add_sub_features(const int16_t* src, int16_t* dst, const int16_t* const* add, int num_added,
+                              const int16_t* const* sub, int num_removed) {
+            for (int offset = 0; offset < HIDDEN_SIZE; offset += TILE_REGS * VEC_LANES) {
+                vec_t tile[TILE_REGS];
+                for (int r = 0; r < TILE_REGS; r++) {
+                    tile[r] = vec_load(src + offset + r * VEC_LANES);
+                }
+                for (int j = 0; j < num_added; j++) {
+                    for (int r = 0; r < TILE_REGS; r++) {
+                        tile[r] = vec_add16(tile[r], vec_load(add[j] + offset + r * VEC_LANES));
+                    }
+                }
+                for (int j = 0; j < num_removed; j++) {
+                    for (int r = 0; r < TILE_REGS; r++) {
+                        tile[r] = vec_sub16(tile[r], vec_load(sub[j] + offset + r * VEC_LANES));
+                    }
+                }
+                for (int r = 0; r < TILE_REGS; r++) {
+                    vec_store(dst + offset + r * VEC_LANES, tile[r]);
+                }
+            }
+        }
+#else
+        const char* const simd_name = "scalar";
+
+        void add_feature(int16_t* acc, const int16_t* weights) {
+            Scalar::add_feature(acc, weights);
+        }
+
+        void sub_feature(int16_t* acc, const int16_t* weights) {
+            Scalar::sub_feature(acc, weights);
+        }
+
+        void add1sub1(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0) {
+            Scalar::add1sub1(src, dst, a0, s0);
+        }
+
+        void add1sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0, const int16_t* s1) {
+            Scalar::add1sub2(src, dst, a0, s0, s1);
+        }
+
+        void add2sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* a1,
+                      const int16_t* s0, const int16_t* s1) {
+            Scalar::add2sub2(src, dst, a0, a1, s0, s1);
+        }
+
+        void add_sub_features(const int16_t* src, int16_t* dst, const int16_t* const* add, int num_added,
+                              const int16_t* const* sub, int num_removed) {
+            Scalar::add_sub_features(src, dst, add, num_added, sub, num_removed);
+        }
+
+        int32_t screlu_dot(const int16_t* stm, const int16_t* ntm, const int16_t* weights) {
+            return Scalar::screlu_dot(stm, ntm, weights);
+        }
+#endif
+    }
     
+    size_t network_file_bytes(const InputLayout& layout, int num_output_buckets) {
+        return (layout.num_king_buckets * INPUT_SIZE * HIDDEN_SIZE + HIDDEN_SIZE +
+                num_output_buckets * (2 * HIDDEN_SIZE + 1)) * sizeof(int16_t);
+    }
+
+    // The kernels keep accumulators in int16 and compute SCReLU as madd(v * w, v) with v * w in int16
+    // A network whose weights don't fit those would silently overflow, so it's rejected up front
+    bool network_in_range(const Network& net, std::string& error) {
+        // |v| <= QA, so v * w fits in int16 as long as QA * |w| does
+        for (int i = 0; i < net.num_output_buckets * 2 * HIDDEN_SIZE; i++) {
+            if (std::abs(net.l1_weights[i]) > INT16_MAX / QA) {
+                error = "l1 weight " + std::to_string(net.l1_weights[i]) + " is out of range (at most " +
+                        std::to_string(INT16_MAX / QA) + " in absolute value)";
+                return false;
+            }
+        }
+        // Worst case accumulator of every neuron: its bias plus its MAX_ACTIVE_FEATURES largest (or smallest)
+        // weights in one king bucket. Incremental updates may wrap in between, only the final value has to fit
+        std::vector<int32_t> column(INPUT_SIZE);
+        for (int bucket = 0; bucket < net.layout.num_king_buckets; bucket++) {
+            const int16_t* weights = net.l0_weights + bucket * INPUT_SIZE * HIDDEN_SIZE;
+            for (int neuron = 0; neuron < HIDDEN_SIZE; neuron++) {
+                for (int feature = 0; feature < INPUT_SIZE; feature++) {
+                    column[feature] = weights[feature * HIDDEN_SIZE + neuron];
+                }
+                // Smallest weights to the front, largest to the back, without sorting the rest
+                std::nth_element(column.begin(), column.begin() + MAX_ACTIVE_FEATURES, column.end());
+                std::nth_element(column.begin() + MAX_ACTIVE_FEATURES, column.end() - MAX_ACTIVE_FEATURES,
+                                 column.end());
+                int32_t low = net.l0_bias[neuron], high = net.l0_bias[neuron];
+                for (int k = 0; k < MAX_ACTIVE_FEATURES; k++) {
+                    low += std::min(column[k], 0);
+                    high += std::max(column[INPUT_SIZE - 1 - k], 0);
+                }
+                if (low < INT16_MIN || high > INT16_MAX) {
+                    error = "accumulator of neuron " + std::to_string(neuron) + " can reach " +
+                            std::to_string(low < INT16_MIN ? low : high) + ", outside int16";
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Point net at weights in quantised.bin order: l0 weights (king bucket by king bucket), l0 bias,
+    // l1 weights (output bucket by output bucket, bullet's transposed save format), l1 biases
+    // The layouts are the ones whose size matches, allowing for up to 64 bytes of padding at the end
+    // On failure error says why: no layout matches, or the weights are out of the kernels' range
+    bool bind_network(const int16_t* data, size_t bytes, Network& net, std::string& error) {
+        for (int i = 0; i < NUM_INPUT_LAYOUTS; i++) {
+            for (int j = 0; j < NUM_OUTPUT_BUCKET_COUNTS; j++) {
+                const InputLayout& layout = INPUT_LAYOUTS[i];
+                int num_output_buckets = OUTPUT_BUCKET_COUNTS[j];
+                size_t expected = network_file_bytes(layout, num_output_buckets);
+                if (bytes < expected || bytes > ((expected + 63) & ~(size_t) 63)) {
+                    continue;
+                }
+                net.layout = layout;
+                net.num_output_buckets = num_output_buckets;
+                net.l0_weights = data;
+                net.l0_bias = net.l0_weights + layout.num_king_buckets * INPUT_SIZE * HIDDEN_SIZE;
+                net.l1_weights = net.l0_bias + HIDDEN_SIZE;
+                net.l1_bias = net.l1_weights + num_output_buckets * 2 * HIDDEN_SIZE;
+                if (!network_in_range(net, error)) {
+                    return false;
+                }
+                static unsigned int last_id = 0;
+                net.id = ++last_id;
+                return true;
+            }
+        }
+        error = "wrong size for any known layout";
+        return false;
+    }
+
+    void release_network_file() {
+        if (!network_file_memory) {
+            return;
+        }
+#if defined(__linux__) || defined(__APPLE__)
+        munmap(network_file_memory, network_file_bytes_mapped);
+#else
+        free(network_file_memory);
+#endif
+        network_file_memory = nullptr;
+        network_file_bytes_mapped = 0;
+    }
+
     bool init_embedded() {
-        // Copy embedded weights into network structure
-        std::memcpy(network.l0_weights, Embedded::l0_weights, 
-                    INPUT_SIZE * HIDDEN_SIZE * sizeof(int16_t));
-        std::memcpy(network.l0_bias, Embedded::l0_bias, 
-                    HIDDEN_SIZE * sizeof(int16_t));
-        std::memcpy(network.l1_weights, Embedded::l1_weights, 
-                    2 * HIDDEN_SIZE * sizeof(int16_t));
-        network.l1_bias = Embedded::l1_bias;
+        // Evaluate straight from the compiled-in weights
+        std::string error;
+        if (!bind_network(Embedded::data, sizeof(Embedded::data), network, error)) {
+            std::cerr << "Embedded NNUE network can't be used: " << error << std::endl;
+            return false;
+        }
+        release_network_file();
         
         network_loaded = true;
-        std::cout << "Successfully loaded embedded NNUE network" << std::endl;
+        get_synced_cout().print("info string Loaded the embedded NNUE network\n");
         return true;
     }
     
@@ -42,7 +431,7 @@ namespace NNUE {
         
         // If file loading fails, fall back to embedded
         if (!success) {
-            std::cout << "Failed to load network from file, trying embedded network..." << std::endl;
+            get_synced_cout().print("info string Failed to load network from file, trying embedded network...\n");
             return init_embedded();
         }
         
@@ -50,38 +439,69 @@ namespace NNUE {
     }
     
     bool load_network(const std::string& path) {
-        std::ifstream file(path, std::ios::binary);
+#if defined(__linux__) || defined(__APPLE__)
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "Failed to open NNUE network file: " << path << std::endl;
+            return false;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == -1) {
+            std::cerr << "Error reading NNUE network file: " << path << std::endl;
+            close(fd);
+            return false;
+        }
+        // Mappings are page aligned, which covers the alignment the kernels would like
+        size_t bytes = file_stat.st_size;
+        void* memory = bytes ? mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (memory == MAP_FAILED) {
+            std::cerr << "Error reading NNUE network file: " << path << std::endl;
+            return false;
+        }
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
         
         if (!file.is_open()) {
             std::cerr << "Failed to open NNUE network file: " << path << std::endl;
             return false;
         }
-        
-        // Read Layer 0 weights (768 * 128 * 2 bytes = 196608 bytes)
-        file.read(reinterpret_cast<char*>(network.l0_weights), 
-                  INPUT_SIZE * HIDDEN_SIZE * sizeof(int16_t));
-        
-        // Read Layer 0 bias (128 * 2 bytes = 256 bytes)
-        file.read(reinterpret_cast<char*>(network.l0_bias), 
-                  HIDDEN_SIZE * sizeof(int16_t));
-        
-        // Read Layer 1 weights (256 * 2 bytes = 512 bytes)
-        file.read(reinterpret_cast<char*>(network.l1_weights), 
-                  2 * HIDDEN_SIZE * sizeof(int16_t));
-        
-        // Read Layer 1 bias (1 * 2 bytes = 2 bytes)
-        file.read(reinterpret_cast<char*>(&network.l1_bias), sizeof(int16_t));
-        
-        if (!file) {
+        size_t bytes = file.tellg();
+        void* memory = aligned_alloc(64, (bytes + 63) & ~(size_t) 63);
+        file.seekg(0);
+        if (!memory || !file.read(static_cast<char*>(memory), bytes)) {
             std::cerr << "Error reading NNUE network file: " << path << std::endl;
-            file.close();
+            free(memory);
+            return false;
+        }
+#endif
+        
+        Network net;
+        std::string error;
+        if (!bind_network(static_cast<const int16_t*>(memory), bytes, net, error)) {
+            std::cerr << "Can't use NNUE network file " << path << ": " << error << std::endl;
+#if defined(__linux__) || defined(__APPLE__)
+            munmap(memory, bytes);
+#else
+            free(memory);
+#endif
             return false;
         }
         
-        file.close();
+        network = net;
+        release_network_file();
+        network_file_memory = memory;
+        network_file_bytes_mapped = bytes;
         network_loaded = true;
         
-        std::cout << "Successfully loaded NNUE network from: " << path << std::endl;
+        // Reported as an info string, this runs in the middle of a UCI session for EvalFile
+        std::ostringstream buffer;
+        buffer << "info string Loaded NNUE network from " << path << " (" << network.layout.name;
+        if (network.num_output_buckets > 1) {
+            buffer << ", " << network.num_output_buckets << " output buckets";
+        }
+        buffer << ")\n";
+        get_synced_cout().print(buffer.str());
         return true;
     }
     
@@ -109,6 +529,83 @@ namespace NNUE {
         }
     }
     
+    // Square of a color's king
+    inline int king_square(const Board& board, int color) {
+        return bitscan_forward(board.get_bitboard(Kings) & board.get_bitboard(color));
+    }
+    
+    // XOR applied to every square seen from a perspective: vertical flip for black, and a horizontal one
+    // on mirrored layouts while the perspective's king is on the e-h files
+    inline int square_orientation(int perspective, int king_square) {
+        int flip = perspective == 0 ? 0 : 56;
+        if (network.layout.mirrored && ((king_square ^ flip) & 4)) {
+            flip ^= 7;
+        }
+        return flip;
+    }
+    
+    // First weight row of the perspective's king bucket
+    inline int bucket_offset(int perspective, int king_square) {
+        return network.layout.king_buckets[king_square ^ (perspective == 0 ? 0 : 56)] * INPUT_SIZE;
+    }
+    
+    // Weight rows of every piece on the board as each perspective sees it, straight from the piece bitboards
+    // Both perspectives come from one walk over the bitboards, so their rows pair up
+    // The row arrays need room for 64 entries, returns how many rows each got
+    int active_rows(const Board& board, const int16_t** white_rows, const int16_t** black_rows) {
+        int white_king = king_square(board, 0);
+        int black_king = king_square(board, 1);
+        const int16_t* white_weights = &network.l0_weights[bucket_offset(0, white_king) * HIDDEN_SIZE];
+        const int16_t* black_weights = &network.l0_weights[bucket_offset(1, black_king) * HIDDEN_SIZE];
+        int white_orientation = square_orientation(0, white_king);
+        int black_orientation = square_orientation(1, black_king);
+        int count = 0;
+        for (int color = 0; color < 2; color++) {
+            for (int piece = PIECE_KING; piece <= PIECE_PAWN; piece++) {
+                // Chess768 type without convert_to_chess768_piece_type's switch: pawn 0 ... king 5, +6 for the opponent
+                const int16_t* white_piece_weights = &white_weights[((PIECE_PAWN - piece) + 6 * color) * 64 * HIDDEN_SIZE];
+                const int16_t* black_piece_weights = &black_weights[((PIECE_PAWN - piece) + 6 * !color) * 64 * HIDDEN_SIZE];
+                for (U64 pieces = board.get_bitboard(color) & board.get_bitboard(piece); pieces; pieces &= pieces - 1) {
+                    int square = bitscan_forward(pieces);
+                    white_rows[count] = &white_piece_weights[(square ^ white_orientation) * HIDDEN_SIZE];
+                    black_rows[count] = &black_piece_weights[(square ^ black_orientation) * HIDDEN_SIZE];
+                    count++;
+                }
+            }
+        }
+        return count;
+    }
+    
+    int get_feature_index(int piece, int square, int color, int perspective, int king_square) {
+        // Chess768 sees the perspective's own pieces as types 0-5 and the opponent's as 6-11
+        int piece_type = convert_to_chess768_piece_type(piece, color != perspective);
+        if (piece_type == -1) {
+            return -1;
+        }
+        return bucket_offset(perspective, king_square) + piece_type * 64 +
+               (square ^ square_orientation(perspective, king_square));
+    }
+    
+    bool needs_refresh(const DirtyPieces& dirty, int perspective) {
+        if (network.layout.num_king_buckets == 1 && !network.layout.mirrored) {
+            return false;
+        }
+        // The king is removed from its old square and added on its new one (castling included)
+        int from = -1, to = -1;
+        for (int i = 0; i < dirty.num_removed; i++) {
+            if (dirty.removed[i].piece == PIECE_KING && dirty.removed[i].color == perspective) {
+                from = dirty.removed[i].square;
+            }
+        }
+        for (int i = 0; i < dirty.num_added; i++) {
+            if (dirty.added[i].piece == PIECE_KING && dirty.added[i].color == perspective) {
+                to = dirty.added[i].square;
+            }
+        }
+        return from != -1 && (bucket_offset(perspective, from) != bucket_offset(perspective, to) ||
+                              square_orientation(perspective, from) != square_orientation(perspective, to));
+    }
+    
     int evaluate(const Board& board) {
         if (!network_loaded) {
             std::cerr << "NNUE network not loaded!" << std::endl;
@@ -118,6 +615,12 @@ namespace NNUE {
         // Get board state
         int current_turn = board.get_current_turn();  // 0 = white, 1 = black
         
+        // Weights of each perspective's king bucket, and how it sees the squares
+        const int16_t* white_weights = &network.l0_weights[bucket_offset(0, king_square(board, 0)) * HIDDEN_SIZE];
+        const int16_t* black_weights = &network.l0_weights[bucket_offset(1, king_square(board, 1)) * HIDDEN_SIZE];
+        int white_orientation = square_orientation(0, king_square(board, 0));
+        int black_orientation = square_orientation(1, king_square(board, 1));
+        
         // Initialize hidden layer activations for both color perspectives
         int32_t white_hidden[HIDDEN_SIZE];  // White's perspective
         int32_t black_hidden[HIDDEN_SIZE];  // Black's perspective
@@ -128,56 +631,30 @@ namespace NNUE {
             black_hidden[i] = network.l0_bias[i];
         }
         
-        // Accumulate features for all pieces
+        // Accumulate features for all pieces, straight from the piece bitboards
         // In Chess768 format:
         // - From white's perspective: white pieces unflipped (0-383), black pieces flipped (384-767)
         // - From black's perspective: black pieces unflipped (0-383), white pieces flipped (384-767)
-        for (int square = 0; square < 64; square++) {
-            unsigned int piece = board.find_piece_occupying_sq(square);
-            
-            if (piece == PIECE_NONE || piece == PIECE_EXTRA) {
-                continue;
-            }
-            
-            // Determine piece color (0 = white, 1 = black)
-            int color = board.is_white_piece(square) ? 0 : 1;
-
-            // Convert piece type to Chess768 format (0-11)
-            int piece_type = convert_to_chess768_piece_type(piece, color);
-            if (piece_type == -1) {
-                continue; // Invalid piece
-            }
-
-            // Chess768: each perspective sees their OWN pieces at their actual squares,
-            // and OPPONENT pieces flipped vertically (square ^ 56)
-            // Feature index: piece_type * 64 + square
-            
-            // For White's perspective:
-            //   - White pieces (types 0-5): square as-is (not flipped)
-            //   - Black pieces (types 6-11): square ^ 56 (flipped)
-            // For Black's perspective:
-            //   - Black pieces (types 6-11 become 0-5): square as-is (not flipped)  
-            //   - White pieces (types 0-5 become 6-11): square ^ 56 (flipped)
-            
-            int white_feature, black_feature;
-            
-            // From white's perspective
-            white_feature = piece_type * 64 + square;
-            
-            // From black's perspective: flip square and swap piece colors
-            int flipped_sq = square ^ 56;
-            int flipped_piece_type;
-            if (piece_type < 6) {
-                flipped_piece_type = piece_type + 6;  // White piece -> Black piece
-            } else {
-                flipped_piece_type = piece_type - 6;  // Black piece -> White piece
-            }
-            black_feature = flipped_piece_type * 64 + flipped_sq;
-            
-            // Add this feature's contribution to the hidden layer
-            for (int i = 0; i < HIDDEN_SIZE; i++) {
-                white_hidden[i] += network.l0_weights[white_feature * HIDDEN_SIZE + i];
-                black_hidden[i] += network.l0_weights[black_feature * HIDDEN_SIZE + i];
+        // offset by the king bucket of the perspective, and mirrored with its king on the e-h files
+        // This walks the bitboards itself rather than using active_rows, so it stays an independent reference
+        for (int color = 0; color < 2; color++) {
+            for (int piece = PIECE_KING; piece <= PIECE_PAWN; piece++) {
+                // Own pieces are types 0-5 for each perspective
+                int white_type = convert_to_chess768_piece_type(piece, color);
+                int black_type = convert_to_chess768_piece_type(piece, !color);
+                U64 pieces = board.get_bitboard(color) & board.get_bitboard(piece);
+                while (pieces) {
+                    int square = bitscan_forward(pieces);
+                    pieces &= pieces - 1;
+                    const int16_t* white_row = &white_weights[(white_type * 64 + (square ^ white_orientation)) * HIDDEN_SIZE];
+                    const int16_t* black_row = &black_weights[(black_type * 64 + (square ^ black_orientation)) * HIDDEN_SIZE];
+                    
+                    // Add this feature's contribution to the hidden layer
+                    for (int i = 0; i < HIDDEN_SIZE; i++) {
+                        white_hidden[i] += white_row[i];
+                        black_hidden[i] += black_row[i];
+                    }
+                }
             }
         }
         
@@ -194,23 +671,26 @@ namespace NNUE {
         // The network always expects: STM perspective, then NTM perspective
         // So if white to move: white_activated first, black_activated second
         // If black to move: black_activated first, white_activated second
-        int32_t output = network.l1_bias;
+        // The output layer is the one of the position's output bucket
+        int bucket = output_bucket(board);
+        const int16_t* l1_weights = &network.l1_weights[bucket * 2 * HIDDEN_SIZE];
+        int32_t output = network.l1_bias[bucket];
         
         if (current_turn == 0) {  // White to move
             // STM = white, NTM = black
             for (int i = 0; i < HIDDEN_SIZE; i++) {
-                output += white_activated[i] * network.l1_weights[i];
+                output += white_activated[i] * l1_weights[i];
             }
             for (int i = 0; i < HIDDEN_SIZE; i++) {
-                output += black_activated[i] * network.l1_weights[HIDDEN_SIZE + i];
+                output += black_activated[i] * l1_weights[HIDDEN_SIZE + i];
             }
         } else {  // Black to move
             // STM = black, NTM = white
             for (int i = 0; i < HIDDEN_SIZE; i++) {
-                output += black_activated[i] * network.l1_weights[i];
+                output += black_activated[i] * l1_weights[i];
             }
             for (int i = 0; i < HIDDEN_SIZE; i++) {
-                output += white_activated[i] * network.l1_weights[HIDDEN_SIZE + i];
+                output += white_activated[i] * l1_weights[HIDDEN_SIZE + i];
             }
         }
         
@@ -221,138 +701,245 @@ namespace NNUE {
         // So total scale is QA * QA * QB = QA^2 * QB
         // We need to divide by (QA * QA * QB) and multiply by SCALE
         
-        int eval = (output * SCALE) / (QA * QA * QB);
+        int eval = dequantize(output);
         
         return eval;
     }
     
-    int get_feature_index(int piece, int square, int perspective) {
-        // piece: 2=KING, 3=QUEEN, 4=ROOK, 5=BISHOP, 6=KNIGHT, 7=PAWN
-        // perspective: 0 = white's view, 1 = black's view
-        
-        // Determine piece color (0 = white, 1 = black) from the piece constant
-        // White pieces: 2-7 with is_white_piece check
-        // Black pieces: 2-7 with !is_white_piece check
-        // We'll need to handle this at the call site since we need board context
-        
-        // This function assumes piece is already converted to Chess768 format (0-11)
-        // and square is already oriented correctly for the perspective
-        return piece * 64 + square;
-    }
-    
-    void refresh_accumulator(Accumulator& acc, const Board& board) {
+    void refresh_accumulator(Accumulator& acc, const Board& board, int perspective, RefreshTable& table) {
         if (!network_loaded) {
             return;
         }
         
-        // Initialize with biases
-        for (int i = 0; i < HIDDEN_SIZE; i++) {
-            acc.white_hidden[i] = network.l0_bias[i];
-            acc.black_hidden[i] = network.l0_bias[i];
+        int num_buckets = network.layout.num_king_buckets;
+        if (table.network_id != network.id) {
+            // Entries start out as an empty board
+            RefreshEntry empty;
+            std::memcpy(empty.hidden, network.l0_bias, sizeof(empty.hidden));
+            std::memset(empty.pieces, 0, sizeof(empty.pieces));
+            table.entries.assign(2 * num_buckets * 2, empty);
+            table.network_id = network.id;
         }
         
-        // Accumulate features for all pieces
-        for (int square = 0; square < 64; square++) {
-            unsigned int piece = board.find_piece_occupying_sq(square);
-            
-            if (piece == PIECE_NONE || piece == PIECE_EXTRA) {
-                continue;
-            }
-            
-            int color = board.is_white_piece(square) ? 0 : 1;
-            int piece_type = convert_to_chess768_piece_type(piece, color);
-            if (piece_type == -1) {
-                continue;
-            }
-            
-            // White's perspective
-            int white_feature = piece_type * 64 + square;
-            
-            // Black's perspective: flip square and swap colors
-            int flipped_sq = square ^ 56;
-            int flipped_piece_type = piece_type < 6 ? piece_type + 6 : piece_type - 6;
-            int black_feature = flipped_piece_type * 64 + flipped_sq;
-            
-            // Bounds check
-            if (white_feature < 0 || white_feature >= INPUT_SIZE || black_feature < 0 || black_feature >= INPUT_SIZE) {
-                std::cerr << "Feature index out of bounds! white=" << white_feature << " black=" << black_feature << std::endl;
-                continue;
+        int king = king_square(board, perspective);
+        int bucket = network.layout.king_buckets[king ^ (perspective == 0 ? 0 : 56)];
+        int orientation = square_orientation(perspective, king);
+        bool mirrored = orientation & 7;
+        RefreshEntry& entry = table.entries[(perspective * num_buckets + bucket) * 2 + mirrored];
+        const int16_t* bucket_weights = &network.l0_weights[bucket * INPUT_SIZE * HIDDEN_SIZE];
+        
+        // Squares whose piece (type or colour) differs between the position and the entry
+        U64 occ = board.get_bitboard(WhitePieces) | board.get_bitboard(BlackPieces);
+        U64 entry_occ = entry.pieces[WhitePieces] | entry.pieces[BlackPieces];
+        U64 changed = (occ ^ entry_occ) | (board.get_bitboard(WhitePieces) ^ entry.pieces[WhitePieces]);
+        for (int piece = PIECE_KING; piece <= PIECE_PAWN; piece++) {
+            changed |= board.get_bitboard(piece) ^ entry.pieces[piece];
+        }
+        
+        // An entry left by an unrelated position would take more rows to fix up than the position has pieces,
+        // then it's rebuilt from the biases like a full refresh: every piece added, nothing removed
+        const int16_t* base = entry.hidden;
+        U64 removed_squares = changed & entry_occ;
+        if (pop_count(changed & occ) + pop_count(removed_squares) > pop_count(occ)) {
+            base = network.l0_bias;
+            changed = occ;
+            removed_squares = 0;
+        }
+        
+        // Weight rows of the pieces that appeared and disappeared since the entry was last used
+        // Chess768 type without convert_to_chess768_piece_type's switch: pawn 0 ... king 5, +6 for the opponent
+        const int16_t* add[64];
+        const int16_t* sub[64];
+        int num_added = 0, num_removed = 0;
+        for (int piece = PIECE_KING; piece <= PIECE_PAWN; piece++) {
+            const int16_t* piece_weights = &bucket_weights[(PIECE_PAWN - piece) * 64 * HIDDEN_SIZE];
+            for (U64 added = board.get_bitboard(piece) & changed; added; added &= added - 1) {
+                int square = bitscan_forward(added);
+                int theirs = board.get_bitboard(!perspective) >> square & 1;
+                add[num_added++] = &piece_weights[(6 * theirs * 64 + (square ^ orientation)) * HIDDEN_SIZE];
             }
-            
-            // Add contributions
-            for (int i = 0; i < HIDDEN_SIZE; i++) {
-                acc.white_hidden[i] += network.l0_weights[white_feature * HIDDEN_SIZE + i];
-                acc.black_hidden[i] += network.l0_weights[black_feature * HIDDEN_SIZE + i];
+            for (U64 removed = entry.pieces[piece] & removed_squares; removed; removed &= removed - 1) {
+                int square = bitscan_forward(removed);
+                int theirs = entry.pieces[!perspective] >> square & 1;
+                sub[num_removed++] = &piece_weights[(6 * theirs * 64 + (square ^ orientation)) * HIDDEN_SIZE];
             }
         }
         
+        Kernels::add_sub_features(base, entry.hidden, add, num_added, sub, num_removed);
+        for (int i = 0; i < 8; i++) {
+            entry.pieces[i] = board.get_bitboard(i);
+        }
+        
+        std::memcpy(acc.hidden(perspective), entry.hidden, sizeof(entry.hidden));
+        
         // Invalidate cached evaluations since accumulator was refreshed
         invalidate_cache(acc);
+        acc.computed[perspective] = true;
     }
     
-    void add_piece_to_accumulator(Accumulator& acc, int piece, int square, int color) {
-        int piece_type = convert_to_chess768_piece_type(piece, color);
-        if (piece_type == -1) {
+    void refresh_accumulator(Accumulator& acc, const Board& board) {
+        if (!network_loaded) {
             return;
         }
         
-        // White's perspective
-        int white_feature = piece_type * 64 + square;
-        
-        // Black's perspective
-        int flipped_sq = square ^ 56;
-        int flipped_piece_type = piece_type < 6 ? piece_type + 6 : piece_type - 6;
-        int black_feature = flipped_piece_type * 64 + flipped_sq;
+        // Gather the weight rows of every piece, then add them to the biases in one pass per perspective
+        const int16_t* white_rows[64];
+        const int16_t* black_rows[64];
+        int num_rows = active_rows(board, white_rows, black_rows);
+        Kernels::add_sub_features(network.l0_bias, acc.white_hidden, white_rows, num_rows, nullptr, 0);
+        Kernels::add_sub_features(network.l0_bias, acc.black_hidden, black_rows, num_rows, nullptr, 0);
         
-        // Bounds check
-        if (white_feature < 0 || white_feature >= INPUT_SIZE || black_feature < 0 || black_feature >= INPUT_SIZE) {
-            std::cerr << "Feature index out of bounds in add! white=" << white_feature << " black=" << black_feature 
-                      << " piece=" << piece << " square=" << square << " color=" << color << std::endl;
-            return;
+        // Invalidate cached evaluations since accumulator was refreshed
+        invalidate_cache(acc);
+        acc.computed[0] = true;
+        acc.computed[1] = true;
+    }
+    
+    void add_piece_to_accumulator(Accumulator& acc, int piece, int square, int color, const int* king_squares) {
+        for (int perspective = 0; perspective < 2; perspective++) {
+            int feature = get_feature_index(piece, square, color, perspective, king_squares[perspective]);
+            if (feature == -1) {
+                return;
+            }
+            Kernels::add_feature(acc.hidden(perspective), &network.l0_weights[feature * HIDDEN_SIZE]);
         }
         
-        // Add to both perspectives
-        for (int i = 0; i < HIDDEN_SIZE; i++) {
-            acc.white_hidden[i] += network.l0_weights[white_feature * HIDDEN_SIZE + i];
-            acc.black_hidden[i] += network.l0_weights[black_feature * HIDDEN_SIZE + i];
+        // Invalidate cached evaluations since accumulator changed
+        invalidate_cache(acc);
+    }
+    
+    void remove_piece_from_accumulator(Accumulator& acc, int piece, int square, int color, const int* king_squares) {
+        for (int perspective = 0; perspective < 2; perspective++) {
+            int feature = get_feature_index(piece, square, color, perspective, king_squares[perspective]);
+            if (feature == -1) {
+                return;
+            }
+            Kernels::sub_feature(acc.hidden(perspective), &network.l0_weights[feature * HIDDEN_SIZE]);
         }
         
         // Invalidate cached evaluations since accumulator changed
         invalidate_cache(acc);
     }
     
-    void remove_piece_from_accumulator(Accumulator& acc, int piece, int square, int color) {
-        int piece_type = convert_to_chess768_piece_type(piece, color);
-        if (piece_type == -1) {
-            return;
+    // Weight rows of the features a move adds and removes, for one perspective
+    inline void dirty_rows(const DirtyPieces& dirty, int perspective, int king_square,
+                           const int16_t** add, int& num_added, const int16_t** sub, int& num_removed) {
+        // The bucket and orientation are the same for every piece, so only work them out once
+        const int16_t* bucket_weights = &network.l0_weights[bucket_offset(perspective, king_square) * HIDDEN_SIZE];
+        int orientation = square_orientation(perspective, king_square);
+        num_added = 0;
+        num_removed = 0;
+
+        for (int i = 0; i < dirty.num_added; i++) {
+            const DirtyPiece& dp = dirty.added[i];
+            int piece_type = convert_to_chess768_piece_type(dp.piece, dp.color != perspective);
+            if (piece_type != -1) {
+                add[num_added++] = &bucket_weights[(piece_type * 64 + (dp.square ^ orientation)) * HIDDEN_SIZE];
+            }
         }
-        
-        // White's perspective
-        int white_feature = piece_type * 64 + square;
-        
-        // Black's perspective
-        int flipped_sq = square ^ 56;
-        int flipped_piece_type = piece_type < 6 ? piece_type + 6 : piece_type - 6;
-        int black_feature = flipped_piece_type * 64 + flipped_sq;
-        
-        // Bounds check
-        if (white_feature < 0 || white_feature >= INPUT_SIZE || black_feature < 0 || black_feature >= INPUT_SIZE) {
-            std::cerr << "Feature index out of bounds in remove! white=" << white_feature << " black=" << black_feature 
-                      << " piece=" << piece << " square=" << square << " color=" << color << std::endl;
+        for (int i = 0; i < dirty.num_removed; i++) {
+            const DirtyPiece& dp = dirty.removed[i];
+            int piece_type = convert_to_chess768_piece_type(dp.piece, dp.color != perspective);
+            if (piece_type != -1) {
+                sub[num_removed++] = &bucket_weights[(piece_type * 64 + (dp.square ^ orientation)) * HIDDEN_SIZE];
+            }
+        }
+    }
+
+    // dst = src + the added rows - the removed rows
+    inline void apply_rows(const int16_t* src, int16_t* dst, const int16_t* const* add, int num_added,
+                           const int16_t* const* sub, int num_removed) {
+        if (num_added == 1 && num_removed == 1) {
+            // Quiet moves and promotions
+            Kernels::add1sub1(src, dst, add[0], sub[0]);
+        } else if (num_added == 1 && num_removed == 2) {
+            // Captures, including en passant and capturing promotions
+            Kernels::add1sub2(src, dst, add[0], sub[0], sub[1]);
+        } else if (num_added == 2 && num_removed == 2) {
+            // Castling
+            Kernels::add2sub2(src, dst, add[0], add[1], sub[0], sub[1]);
+        } else {
+            // Null moves and anything else: copy, then apply features one at a time
+            std::memcpy(dst, src, HIDDEN_SIZE * sizeof(int16_t));
+            for (int i = 0; i < num_removed; i++) {
+                Kernels::sub_feature(dst, sub[i]);
+            }
+            for (int i = 0; i < num_added; i++) {
+                Kernels::add_feature(dst, add[i]);
+            }
+        }
+    }
+
+    void apply_dirty_pieces(const Accumulator& parent, Accumulator& child, const DirtyPieces& dirty,
+                            int perspective, int king_square) {
+        const int16_t* add[2];
+        const int16_t* sub[2];
+        int num_added, num_removed;
+        dirty_rows(dirty, perspective, king_square, add, num_added, sub, num_removed);
+        apply_rows(parent.hidden(perspective), child.hidden(perspective), add, num_added, sub, num_removed);
+
+        invalidate_cache(child);
+        child.computed[perspective] = true;
+    }
+
+    void apply_dirty_pieces(const Accumulator& parent, Accumulator& child, const DirtyPieces& dirty,
+                            const int* king_squares) {
+        const int16_t* white_add[2];
+        const int16_t* white_sub[2];
+        const int16_t* black_add[2];
+        const int16_t* black_sub[2];
+        int num_added, num_removed;
+        dirty_rows(dirty, 0, king_squares[0], white_add, num_added, white_sub, num_removed);
+        dirty_rows(dirty, 1, king_squares[1], black_add, num_added, black_sub, num_removed);
+        apply_rows(parent.white_hidden, child.white_hidden, white_add, num_added, white_sub, num_removed);
+        apply_rows(parent.black_hidden, child.black_hidden, black_add, num_added, black_sub, num_removed);
+
+        invalidate_cache(child);
+        child.computed[0] = true;
+        child.computed[1] = true;
+    }
+    
+    void evaluate_positions(const Board* boards, int count, int* evals, RefreshTable& table) {
+        if (!network_loaded) {
+            std::cerr << "NNUE network not loaded!" << std::endl;
+            std::fill(evals, evals + count, 0);
             return;
         }
         
-        // Remove from both perspectives
-        for (int i = 0; i < HIDDEN_SIZE; i++) {
-            acc.white_hidden[i] -= network.l0_weights[white_feature * HIDDEN_SIZE + i];
-            acc.black_hidden[i] -= network.l0_weights[black_feature * HIDDEN_SIZE + i];
+        Accumulator acc;
+        for (int i = 0; i < count; i++) {
+            const Board& board = boards[i];
+            
+            // Squares whose contents differ from the previous position
+            U64 changed = i == 0 ? ~C64(0) : 0;
+            for (int bb = 0; i > 0 && bb < 8; bb++) {
+                changed |= board.get_bitboard(bb) ^ boards[i - 1].get_bitboard(bb);
+            }
+            
+            // Positions from the same game differ in a few squares and go through the table, for anything else
+            // one walk over the pieces for both perspectives is quicker than diffing each perspective's entry
+            if (2 * pop_count(changed) < pop_count(board.get_bitboard(WhitePieces) | board.get_bitboard(BlackPieces))) {
+                refresh_accumulator(acc, board, 0, table);
+                refresh_accumulator(acc, board, 1, table);
+            } else {
+                refresh_accumulator(acc, board);
+            }
+            evals[i] = evaluate_incremental(acc, board.get_current_turn(), output_bucket(board));
         }
-        
-        // Invalidate cached evaluations since accumulator changed
-        invalidate_cache(acc);
     }
     
-    int evaluate_incremental(Accumulator& acc, int side_to_move) {
+    int output_bucket(const Board& board) {
+        if (network.num_output_buckets == 1) {
+            return 0;
+        }
+        // 2 to 32 pieces map to buckets 0 to 7
+        // read_FEN takes positions with more than 32 pieces, those share the last bucket
+        int num_pieces = pop_count(board.get_bitboard(WhitePieces) | board.get_bitboard(BlackPieces));
+        return std::min(std::max(num_pieces - 2, 0) / (32 / network.num_output_buckets),
+                        network.num_output_buckets - 1);
+    }
+    
+    int evaluate_incremental(Accumulator& acc, int side_to_move, int bucket) {
         if (!network_loaded) {
             std::cerr << "NNUE network not loaded!" << std::endl;
             return 0;
@@ -366,35 +953,14 @@ namespace NNUE {
             return acc.cached_eval_black;
         }
         
-        // Apply SCReLU activation
-        int32_t white_activated[HIDDEN_SIZE];
-        int32_t black_activated[HIDDEN_SIZE];
-        
-        for (int i = 0; i < HIDDEN_SIZE; i++) {
-            white_activated[i] = screlu(acc.white_hidden[i]);
-            black_activated[i] = screlu(acc.black_hidden[i]);
-        }
-        
-        // Compute output layer
-        int32_t output = network.l1_bias;
-        
-        if (side_to_move == 0) {  // White to move
-            for (int i = 0; i < HIDDEN_SIZE; i++) {
-                output += white_activated[i] * network.l1_weights[i];
-            }
-            for (int i = 0; i < HIDDEN_SIZE; i++) {
-                output += black_activated[i] * network.l1_weights[HIDDEN_SIZE + i];
-            }
-        } else {  // Black to move
-            for (int i = 0; i < HIDDEN_SIZE; i++) {
-                output += black_activated[i] * network.l1_weights[i];
-            }
-            for (int i = 0; i < HIDDEN_SIZE; i++) {
-                output += white_activated[i] * network.l1_weights[HIDDEN_SIZE + i];
-            }
-        }
+        // SCReLU activation and output layer
+        // The network always expects: STM perspective, then NTM perspective
+        const int16_t* stm = side_to_move == 0 ? acc.white_hidden : acc.black_hidden;
+        const int16_t* ntm = side_to_move == 0 ? acc.black_hidden : acc.white_hidden;
+        int32_t output = network.l1_bias[bucket] +
+                         Kernels::screlu_dot(stm, ntm, &network.l1_weights[bucket * 2 * HIDDEN_SIZE]);
         
-        int eval = (output * SCALE) / (QA * QA * QB);
+        int eval = dequantize(output);
         
         // Cache the result
         if (side_to_move == 0) {
@@ -3,10 +3,10 @@
 //  Tuna Chess Engine
 //
 //  NNUE (Efficiently Updatable Neural Network) Evaluation
-//  Architecture: (768 -> 128)x2 -> 1
-//  - Input: 768 features (piece-square inputs, dual perspective)
+//  Architecture: (768 -> 128)x2 -> 1, optionally with king buckets and output buckets: (N x 768 -> 128)x2 -> M x 1
+//  - Input: 768 features (piece-square inputs, dual perspective), per king bucket
 //  - Hidden: 128 neurons per perspective with SCReLU activation
-//  - Output: Single evaluation score
+//  - Output: Single evaluation score, from the output bucket picked by the number of pieces on the board
 //
 
 #ifndef NNUE_hpp
@@ -22,6 +22,7 @@ namespace NNUE {
     // Network architecture constants
     constexpr int INPUT_SIZE = 768;
     constexpr int HIDDEN_SIZE = 128;
+    constexpr int MAX_ACTIVE_FEATURES = 32; // One per piece, what the accumulator range check allows for
     constexpr int OUTPUT_SIZE = 1;
     
     // Quantization parameters (must match training)
@@ -36,33 +37,90 @@ namespace NNUE {
     constexpr bool USE_INCREMENTAL = true;
     
     // Accumulator structure for incremental updates
-    struct Accumulator {
-        int32_t white_hidden[HIDDEN_SIZE];  // White's perspective accumulator
-        int32_t black_hidden[HIDDEN_SIZE];  // Black's perspective accumulator
+    // Lanes are int16: |bias| + 32 active features * max |l0 weight| stays far below 2^15,
+    // and one AVX2 register then covers 16 neurons
+    // Cache line aligned so no hidden vector straddles a line; C++17 aligned new keeps that in the std::vector stack.
+    // The kernels still use unaligned loads, since the weights they're paired with sit in the raw network blob
+    struct alignas(64) Accumulator {
+        int16_t white_hidden[HIDDEN_SIZE];  // White's perspective accumulator
+        int16_t black_hidden[HIDDEN_SIZE];  // Black's perspective accumulator
+        
+        int16_t* hidden(int perspective) { return perspective == 0 ? white_hidden : black_hidden; }
+        const int16_t* hidden(int perspective) const { return perspective == 0 ? white_hidden : black_hidden; }
         
         // Cached evaluation results (avoid recomputing if accumulator unchanged)
         int16_t cached_eval_white;  // Cached eval when white to move
         int16_t cached_eval_black;  // Cached eval when black to move
         bool white_cache_valid;     // Is white cache valid?
         bool black_cache_valid;     // Is black cache valid?
+
+        // Are the hidden values up to date, per perspective (0 = white, 1 = black)?
+        // Children on the accumulator stack are computed lazily, and a king bucket change only
+        // invalidates the moving side's perspective
+        bool computed[2];
         
         // Constructor to initialize cache as invalid
         Accumulator() : cached_eval_white(0), cached_eval_black(0), 
-                       white_cache_valid(false), black_cache_valid(false) {}
+                       white_cache_valid(false), black_cache_valid(false), computed{false, false} {}
+    };
+    
+    // Refresh ("Finny") table entry: the last accumulator computed for one perspective with its king in a given
+    // bucket and mirroring, and the pieces it was computed from. Refreshing into it only applies the difference
+    struct RefreshEntry {
+        int16_t hidden[HIDDEN_SIZE];
+        U64 pieces[8]; // Board bitboards (colors, then piece types)
+    };
+    
+    // Entries for every bucket and mirroring of both perspectives, one table per search thread
+    // Any position can be refreshed from any entry, so the table doesn't depend on the board it's used with
+    struct RefreshTable {
+        unsigned int network_id = 0; // Network the entries were computed with, they're reset when it changes
+        std::vector<RefreshEntry> entries;
+    };
+    
+    // How the input layer depends on the friendly king, per perspective
+    // Squares are seen from the perspective's side (flipped vertically for black). With mirroring, a king
+    // on the e-h files flips every square horizontally so the king always sits on the a-d files
+    // Each king bucket has its own INPUT_SIZE rows of layer 0 weights
+    struct InputLayout {
+        const char* name;
+        int num_king_buckets;
+        bool mirrored;
+        uint8_t king_buckets[64]; // Bucket of each (perspective relative) king square, a1 = 0
     };
     
-    // Network weights (quantized to int16)
-    struct alignas(64) Network {
-        // Layer 0: Feature transformer (768 -> 128)
-        int16_t l0_weights[INPUT_SIZE * HIDDEN_SIZE];
-        int16_t l0_bias[HIDDEN_SIZE];
+    // Layouts load_network knows, told apart by the size of the file
+    // Trainers have to use the same bucket maps
+    extern const InputLayout INPUT_LAYOUTS[];
+    extern const int NUM_INPUT_LAYOUTS;
+    
+    // Output bucket counts load_network knows, also told apart by the size of the file
+    // With 8 buckets the output layer is picked by material: (pieces on the board - 2) / 4, like bullet's MaterialCount<8>
+    constexpr int OUTPUT_BUCKET_COUNTS[] = {1, 8};
+    constexpr int NUM_OUTPUT_BUCKET_COUNTS = sizeof(OUTPUT_BUCKET_COUNTS) / sizeof(OUTPUT_BUCKET_COUNTS[0]);
+    
+    // Network weights (quantized to int16), pointing into the embedded weights or a mapped network file
+    struct Network {
+        // Layer 0: Feature transformer (num_king_buckets * 768 -> 128)
+        const int16_t* l0_weights;
+        const int16_t* l0_bias;
         
-        // Layer 1: Output layer (256 -> 1)
-        int16_t l1_weights[2 * HIDDEN_SIZE];
-        int16_t l1_bias;
+        // Layer 1: Output layer (256 -> 1), one per output bucket
+        const int16_t* l1_weights; // num_output_buckets rows of 2 * HIDDEN_SIZE
+        const int16_t* l1_bias;    // num_output_buckets values
+        
+        InputLayout layout;
+        int num_output_buckets;
+        
+        // Changes with every network loaded, a new mapping could reuse an old one's address
+        unsigned int id;
     };
     
-    // Global network instance
+    // Size of a quantised.bin with the given layouts, without the padding bullet adds to reach a multiple of 64 bytes
+    size_t network_file_bytes(const InputLayout& layout, int num_output_buckets);
+    
+    // Network the evaluation reads from
+    // Only swap it between searches, accumulators built with the old weights have to be refreshed after
     extern Network network;
     extern bool network_loaded;
     
@@ -72,13 +130,16 @@ namespace NNUE {
     // Initialize NNUE from file
     bool init(const std::string& path);
     
-    // Load network weights from quantized binary file
+    // Map a quantised.bin read-only and evaluate straight from it, nothing is copied
+    // The input layout and output buckets are detected from the file size (see INPUT_LAYOUTS and
+    // OUTPUT_BUCKET_COUNTS), allowing for bullet's padding
+    // Returns false and keeps the current network if the file can't be used
     bool load_network(const std::string& path);
     
     // Check if network is loaded
     bool is_loaded();
     
-    // Feature indexing for piece-square representation (Chess768 format)
+    // Feature indexing for piece-square representation (Chess768 format, within the king bucket's rows)
     // Format: 768 features = 12 piece types × 64 squares
     // Piece types: White P,N,B,R,Q,K (0-5), Black p,n,b,r,q,k (6-11)
     // Feature index = piece_type * 64 + square
@@ -92,27 +153,58 @@ namespace NNUE {
     // - From white's perspective: white pieces at actual squares, black pieces flipped
     // - From black's perspective: black pieces at actual squares, white pieces flipped
     // Square numbering: 0=a1, 1=b1, ..., 7=h1, 8=a2, ..., 63=h8
+    // Mirrored layouts additionally flip files (square ^ 7) while the perspective's king is on the e-h files
     
     // Non-incremental evaluation (recalculates from scratch)
+    // Uses plain int32 scalar code so it can serve as a reference for the accumulator kernels
     // Returns evaluation in centipawns from the perspective of the side to move
     int evaluate(const Board& board);
     
+    // Output bucket of a position, 0 for networks without output buckets
+    int output_bucket(const Board& board);
+    
     // Incremental evaluation using pre-computed accumulator
+    // bucket is the position's output_bucket
     // Returns evaluation in centipawns from the perspective of the side to move
     // NOTE: Takes non-const reference to cache evaluation results
-    int evaluate_incremental(Accumulator& acc, int side_to_move);
+    int evaluate_incremental(Accumulator& acc, int side_to_move, int bucket);
+    
+    // Evaluate count positions one after the other, a convenience loop for scoring position files (same results
+    // as evaluate). Nothing is vectorised across positions, the only shared work is the table: accumulators are
+    // built from its entries, so positions that share most of their pieces with an earlier one (consecutive
+    // positions of a game) only apply the difference. Keep the table between calls
+    // Only the bitboards and side to move of the boards are read
+    void evaluate_positions(const Board* boards, int count, int* evals, RefreshTable& table);
     
     // Refresh accumulator from scratch by computing all active features
     void refresh_accumulator(Accumulator& acc, const Board& board);
     
-    // Get feature index for a piece on a square from a given perspective
-    // perspective: 0 = white's view, 1 = black's view
-    int get_feature_index(int piece, int square, int perspective);
+    // Refresh one perspective only, after its king changed bucket or mirroring
+    // Starts from the table's entry for the king's bucket, so only the pieces that changed since are applied
+    void refresh_accumulator(Accumulator& acc, const Board& board, int perspective, RefreshTable& table);
+    
+    // Get feature index (weight row) for a piece on a square from a given perspective
+    // piece: Board piece type (2-7), color: 0=white 1=black, perspective: 0 = white's view, 1 = black's view
+    // king_square: square of the perspective's own king, which picks the bucket and mirroring
+    int get_feature_index(int piece, int square, int color, int perspective, int king_square);
+    
+    // Does a move need a refresh of the perspective (its king moved to another bucket or across the mirror)?
+    bool needs_refresh(const DirtyPieces& dirty, int perspective);
     
     // Update accumulator for piece movement (handles both perspectives)
     // piece: Board piece type (2-7), square: 0-63, color: 0=white 1=black
-    void add_piece_to_accumulator(Accumulator& acc, int piece, int square, int color);
-    void remove_piece_from_accumulator(Accumulator& acc, int piece, int square, int color);
+    // king_squares: white and black king squares
+    void add_piece_to_accumulator(Accumulator& acc, int piece, int square, int color, const int* king_squares);
+    void remove_piece_from_accumulator(Accumulator& acc, int piece, int square, int color, const int* king_squares);
+    
+    // Compute one perspective of child = parent with the dirty pieces of a move added and removed
+    // The move must not need a refresh of the perspective, king_square is its king's square
+    void apply_dirty_pieces(const Accumulator& parent, Accumulator& child, const DirtyPieces& dirty,
+                            int perspective, int king_square);
+    
+    // Both perspectives at once, king_squares are the white and black king squares
+    void apply_dirty_pieces(const Accumulator& parent, Accumulator& child, const DirtyPieces& dirty,
+                            const int* king_squares);
     
     // Invalidate cached evaluation (call after updating accumulator)
     inline void invalidate_cache(Accumulator& acc) {
@@ -120,6 +212,61 @@ namespace NNUE {
         acc.black_cache_valid = false;
     }
     
+    // Vectorized kernels over HIDDEN_SIZE int16 lanes
+    // The implementation is picked at compile time: AVX-512BW, AVX2, SSE4.1, then scalar
+    // The scalar versions are always built so they can be benchmarked against the SIMD ones
+    namespace Kernels {
+        // Name of the instruction set the active kernels were compiled for
+        extern const char* const simd_name;
+
+        // acc[i] += weights[i]
+        void add_feature(int16_t* acc, const int16_t* weights);
+
+        // acc[i] -= weights[i]
+        void sub_feature(int16_t* acc, const int16_t* weights);
+
+        // Fused updates streaming the parent into the child in one pass
+        // dst[i] = src[i] + a0[i] (+ a1[i]) - s0[i] (- s1[i])
+        void add1sub1(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0);
+
+        void add1sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0, const int16_t* s1);
+
+        void add2sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* a1,
+                      const int16_t* s0, const int16_t* s1);
+
+        // Any number of features: dst[i] = src[i] + sum(add[j][i]) - sum(sub[j][i])
+        // The accumulator is kept in registers while every row is applied, so it's streamed once
+        void add_sub_features(const int16_t* src, int16_t* dst, const int16_t* const* add, int num_added,
+                              const int16_t* const* sub, int num_removed);
+
+        // sum(screlu(stm[i]) * weights[i]) + sum(screlu(ntm[i]) * weights[HIDDEN_SIZE + i])
+        int32_t screlu_dot(const int16_t* stm, const int16_t* ntm, const int16_t* weights);
+
+        namespace Scalar {
+            void add_feature(int16_t* acc, const int16_t* weights);
+
+            void sub_feature(int16_t* acc, const int16_t* weights);
+
+            void add1sub1(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0);
+
+            void add1sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* s0, const int16_t* s1);
+
+            void add2sub2(const int16_t* src, int16_t* dst, const int16_t* a0, const int16_t* a1,
+                          const int16_t* s0, const int16_t* s1);
+
+            void add_sub_features(const int16_t* src, int16_t* dst, const int16_t* const* add, int num_added,
+                                  const int16_t* const* sub, int num_removed);
+
+            int32_t screlu_dot(const int16_t* stm, const int16_t* ntm, const int16_t* weights);
+        }
+    }
+
+    // Convert the raw output layer sum to centipawns
+    // The sum is scaled by QA^2 * QB; widen before multiplying by SCALE so large evals don't overflow
+    inline int dequantize(int32_t output) {
+        return static_cast<int>((static_cast<int64_t>(output) * SCALE) / (QA * QA * QB));
+    }
+
     // SCReLU activation function (Squared Clipped ReLU)
     // SCReLU(x) = min(max(x, 0), 1)^2
     inline int32_t screlu(int32_t x) {
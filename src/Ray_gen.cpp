@@ -8,7 +8,7 @@
 
 #include "Ray_gen.hpp"
 
-const U64 RMagic[64] = {
+constexpr U64 RMagic[64] = {
         0xa8002c000108020ULL,
         0x6c00049b0002001ULL,
         0x100200010090040ULL,
@@ -75,7 +75,7 @@ const U64 RMagic[64] = {
         0x26002114058042ULL,
 };
 
-const U64 BMagic[64] = {
+constexpr U64 BMagic[64] = {
         0x89a1121896040240ULL,
         0x2004844802002010ULL,
         0x2068080051921000ULL,
@@ -142,50 +142,115 @@ const U64 BMagic[64] = {
         0x40102000a0a60140ULL,
 };
 
-U64 bishop_move_table[64][1024];
-U64 rook_move_table[64][4096];
+// The attack tables hold the attacks of every subset of a square's blocker mask, computed like the classical
+// ray attacks. The rays are copied into plain arrays first: the rook table has 100K entries, and every
+// std::array subscript is a call when it's evaluated in a constant expression
+struct SliderRays {
+    U64 positive[2][64]; // Blockers found with bitscan_forward
+    U64 negative[2][64]; // Blockers found with bitscan_reverse
+};
 
+constexpr SliderRays gen_slider_rays(Directions positive1, Directions positive2, Directions negative1,
+                                     Directions negative2) {
+    SliderRays slider_rays{};
+    for (int sq = 0; sq < 64; sq++) {
+        slider_rays.positive[0][sq] = rays[positive1][sq];
+        slider_rays.positive[1][sq] = rays[positive2][sq];
+        slider_rays.negative[0][sq] = rays[negative1][sq];
+        slider_rays.negative[1][sq] = rays[negative2][sq];
+    }
+    return slider_rays;
+}
 
-U64 get_positive_ray_attacks(int from_square, Directions dir, U64 occ) {
-    // Gets ray attacks in directions North, NorthEast, NorthWest, East
-    U64 attacks = rays[dir][from_square];
-    U64 blockers = attacks & occ;
-    int blocker = bitscan_forward(blockers | C64(0x8000000000000000));
-    return attacks ^ rays[dir][blocker];
+constexpr U64 slider_attacks(const SliderRays& r, int sq, U64 occ) {
+    U64 attacks = EmptyBoard;
+    for (int i = 0; i < 2; i++) {
+        attacks |= r.positive[i][sq] ^ r.positive[i][bitscan_forward((r.positive[i][sq] & occ) | C64(0x8000000000000000))];
+        attacks |= r.negative[i][sq] ^ r.negative[i][bitscan_reverse((r.negative[i][sq] & occ) | C64(1))];
+    }
+    return attacks;
 }
 
-U64 get_negative_ray_attacks(int from_square, Directions dir, U64 occ) {
-    // Gets ray attacks in directions West, SouthWest, South, SouthEast
-    U64 attacks = rays[dir][from_square];
-    U64 blockers = attacks & occ;
-    int blocker = bitscan_reverse(blockers | C64(1));
-    return attacks ^ rays[dir][blocker];
+constexpr SliderRays bishop_slider_rays = gen_slider_rays(NorthEast, NorthWest, SouthEast, SouthWest);
+constexpr SliderRays rook_slider_rays = gen_slider_rays(North, East, South, West);
+
+// Carry-Rippler enumerates the subsets of a mask in the order of their PEXT index
+template<size_t table_size>
+constexpr std::array<U64, table_size> gen_pext_table(const std::array<U64, 64>& masks, const SliderRays& r) {
+    std::array<U64, table_size> table{};
+    size_t offset = 0;
+    for (int sq = 0; sq < 64; sq++) {
+        U64 mask = masks[sq];
+        U64 subset = 0;
+        do {
+            table[offset++] = slider_attacks(r, sq, subset);
+            subset = (subset - mask) & mask;
+        } while (subset);
+    }
+    return table;
 }
 
-U64 bishop_attacks_classical(int from_index, U64 occ) {
-    // Combines appropriate ray attacks for diagonal attacks
-    return get_positive_ray_attacks(from_index, NorthEast, occ) | get_positive_ray_attacks(from_index, NorthWest, occ) |
-           get_negative_ray_attacks(from_index, SouthEast, occ) | get_negative_ray_attacks(from_index, SouthWest, occ);
+constexpr std::array<unsigned int, 64> gen_pext_offsets(const std::array<U64, 64>& masks) {
+    std::array<unsigned int, 64> offsets{};
+    unsigned int offset = 0;
+    for (int sq = 0; sq < 64; sq++) {
+        offsets[sq] = offset;
+        offset += 1 << pop_count(masks[sq]);
+    }
+    return offsets;
 }
 
-U64 rook_attacks_classical(int from_index, U64 occ) {
-    // Combines appropiate ray attacks for rank-and-file attacks
-    return get_positive_ray_attacks(from_index, North, occ) | get_positive_ray_attacks(from_index, East, occ) |
-           get_negative_ray_attacks(from_index, South, occ) | get_negative_ray_attacks(from_index, West, occ);
+template<size_t entries>
+constexpr std::array<std::array<U64, entries>, 64> gen_magic_table(const std::array<U64, 64>& masks, const U64* magics,
+                                                                   const SliderRays& r) {
+    std::array<std::array<U64, entries>, 64> table{};
+    for (int sq = 0; sq < 64; sq++) {
+        U64 mask = masks[sq];
+        int bits = pop_count(mask);
+        U64 subset = 0;
+        do {
+            table[sq][(subset * magics[sq]) >> (64 - bits)] = slider_attacks(r, sq, subset);
+            subset = (subset - mask) & mask;
+        } while (subset);
+    }
+    return table;
 }
 
+#if USE_PEXT
+constexpr std::array<U64, BISHOP_PEXT_TABLE_SIZE> bishop_pext_table =
+        gen_pext_table<BISHOP_PEXT_TABLE_SIZE>(bishop_rays, bishop_slider_rays);
+constexpr std::array<U64, ROOK_PEXT_TABLE_SIZE> rook_pext_table =
+        gen_pext_table<ROOK_PEXT_TABLE_SIZE>(rook_rays, rook_slider_rays);
+constexpr std::array<unsigned int, 64> bishop_pext_offset = gen_pext_offsets(bishop_rays);
+constexpr std::array<unsigned int, 64> rook_pext_offset = gen_pext_offsets(rook_rays);
+#else
+constexpr std::array<std::array<U64, 1024>, 64> bishop_move_table =
+        gen_magic_table<1024>(bishop_rays, BMagic, bishop_slider_rays);
+constexpr std::array<std::array<U64, 4096>, 64> rook_move_table =
+        gen_magic_table<4096>(rook_rays, RMagic, rook_slider_rays);
+#endif
+
+
 U64 bishop_attacks(int from_index, U64 occ) {
+#if USE_PEXT
+    return bishop_pext_table[bishop_pext_offset[from_index] + _pext_u64(occ, bishop_rays[from_index])];
+#else
     int bits = pop_count(bishop_rays[from_index]);
     U64 blockers = bishop_rays[from_index] & occ;
     U64 key = (blockers * BMagic[from_index]) >> (64 - bits);
     return bishop_move_table[from_index][key];
+#endif
 }
 
 U64 rook_attacks(int from_index, U64 occ) {
+#if USE_PEXT
+    return rook_pext_table[rook_pext_offset[from_index] + _pext_u64(occ, rook_rays[from_index])];
+#else
     int bits = pop_count(rook_rays[from_index]);
     U64 blockers = rook_rays[from_index] & occ;
     U64 key = (blockers * RMagic[from_index]) >> (64 - bits);
     return rook_move_table[from_index][key];
+#endif
 }
 
 U64 xray_bishop_attacks(int from_index, U64 occ, U64 blockers) {
@@ -211,52 +276,3 @@ U64 in_between_mask(int from_index, int to_index) {
     U64 ray_to = rays[dir][to_index];
     return ray_from ^ ray_to;
 }
-
-
-/* Generate a unique blocker board, given an index (0..2^bits) and the blocker mask
- * for the piece/square. Each index will give a unique blocker board.
- * Sourced from https://stackoverflow.com/questions/30680559/how-to-find-magic-bitboards
- */
-U64 gen_blockerboard(int index, U64 blockermask) {
-    /* Start with a blockerboard identical to the mask. */
-    U64 blockerboard = blockermask;
-
-    /* Loop through the blockermask to find the indices of all set bits. */
-    int bitindex = 0;
-    for (int i = 0; i < 64; i++) {
-        /* Check if the i'th bit is set in the mask (and thus a potential blocker). */
-        if (blockermask & (1ULL << i)) {
-            /* Clear the i'th bit in the blockerboard if it's clear in the index at bitindex. */
-            if (!(index & (1 << bitindex))) {
-                blockerboard &= ~(1ULL << i); //Clear the bit.
-            }
-            /* Increment the bit index in the 0-4096 index, so each bit in index will correspond
-             * to each set bit in blockermask. */
-            bitindex++;
-        }
-    }
-    return blockerboard;
-}
-
-void init_ray_gen() {
-    // Init magic_BB stuff
-
-    // Bishop
-    for (int sq = 0; sq < 64; sq++) {
-        int bits = pop_count(bishop_rays[sq]);
-        for (int i = 0; i < (1 << bits); i++) {
-            U64 blockers = gen_blockerboard(i, bishop_rays[sq]);
-            U64 key = (blockers * BMagic[sq]) >> (64 - bits);
-            bishop_move_table[sq][key] = bishop_attacks_classical(sq, blockers);
-        }
-    }
-    // Rook
-    for (int sq = 0; sq < 64; sq++) {
-        int bits = pop_count(rook_rays[sq]);
-        for (int i = 0; i < (1 << bits); i++) {
-            U64 blockers = gen_blockerboard(i, rook_rays[sq]);
-            U64 key = (blockers * RMagic[sq]) >> (64 - bits);
-            rook_move_table[sq][key] = rook_attacks_classical(sq, blockers);
-        }
-    }
-}
@@ -13,21 +13,63 @@
 #include "Bitboard.hpp"
 #include "Data_structs.hpp"
 
+// Slider attacks are indexed with BMI2 PEXT when the target has it, magic multiplication otherwise
+// PEXT is microcoded (and slower than magics) on AMD before Zen 3, configure with -DTUNA_USE_PEXT=OFF there
+#if defined(__BMI2__) && !defined(NO_PEXT)
+#define USE_PEXT 1
+#include <immintrin.h>
+#else
+#define USE_PEXT 0
+#endif
+
+// Sum of 2^(relevant blocker squares) over all squares
+#define ROOK_PEXT_TABLE_SIZE 102400
+#define BISHOP_PEXT_TABLE_SIZE 5248
+
 extern const U64 RMagic[64];
 
 extern const U64 BMagic[64];
 
-extern U64 bishop_move_table[64][1024];
-extern U64 rook_move_table[64][4096];
-
-
-U64 get_positive_ray_attacks(int from_square, Directions dir, U64 occ);
-
-U64 get_negative_ray_attacks(int from_square, Directions dir, U64 occ);
-
-U64 bishop_attacks_classical(int from_index, U64 occ);
-
-U64 rook_attacks_classical(int from_index, U64 occ);
+// Attack tables are generated at compile time (in Ray_gen.cpp) from the classical ray attacks
+#if USE_PEXT
+// Attacks of all squares packed one after the other, a square's start at its offset
+extern const std::array<U64, BISHOP_PEXT_TABLE_SIZE> bishop_pext_table;
+extern const std::array<U64, ROOK_PEXT_TABLE_SIZE> rook_pext_table;
+extern const std::array<unsigned int, 64> bishop_pext_offset;
+extern const std::array<unsigned int, 64> rook_pext_offset;
+#else
+extern const std::array<std::array<U64, 1024>, 64> bishop_move_table;
+extern const std::array<std::array<U64, 4096>, 64> rook_move_table;
+#endif
+
+
+constexpr U64 get_positive_ray_attacks(int from_square, Directions dir, U64 occ) {
+    // Gets ray attacks in directions North, NorthEast, NorthWest, East
+    U64 attacks = rays[dir][from_square];
+    U64 blockers = attacks & occ;
+    int blocker = bitscan_forward(blockers | C64(0x8000000000000000));
+    return attacks ^ rays[dir][blocker];
+}
+
+constexpr U64 get_negative_ray_attacks(int from_square, Directions dir, U64 occ) {
+    // Gets ray attacks in directions West, SouthWest, South, SouthEast
+    U64 attacks = rays[dir][from_square];
+    U64 blockers = attacks & occ;
+    int blocker = bitscan_reverse(blockers | C64(1));
+    return attacks ^ rays[dir][blocker];
+}
+
+constexpr U64 bishop_attacks_classical(int from_index, U64 occ) {
+    // Combines appropriate ray attacks for diagonal attacks
+    return get_positive_ray_attacks(from_index, NorthEast, occ) | get_positive_ray_attacks(from_index, NorthWest, occ) |
+           get_negative_ray_attacks(from_index, SouthEast, occ) | get_negative_ray_attacks(from_index, SouthWest, occ);
+}
+
+constexpr U64 rook_attacks_classical(int from_index, U64 occ) {
+    // Combines appropiate ray attacks for rank-and-file attacks
+    return get_positive_ray_attacks(from_index, North, occ) | get_positive_ray_attacks(from_index, East, occ) |
+           get_negative_ray_attacks(from_index, South, occ) | get_negative_ray_attacks(from_index, West, occ);
+}
 
 U64 bishop_attacks(int from_index, U64 occ);
 
@@ -39,9 +81,5 @@ U64 xray_rook_attacks(int from_index, U64 occ, U64 blockers);
 
 U64 in_between_mask(int from_index, int to_index);
 
-U64 gen_blockerboard(int index, U64 blockermask);
-
-void init_ray_gen();
-
 
 #endif /* Ray_gen_hpp */
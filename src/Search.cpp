@@ -11,11 +11,16 @@
 #include <cmath>
 
 unsigned int lmr_table[64][64];
+
+// Lazy SMP: helper i (thread id i + 1, wrapping every HELPER_SCHEDULES) skips the depths d with
+// ((d + helper_skip_phase[i]) / helper_skip_size[i]) odd, so the helpers spread over many different
+// iterative deepening schedules instead of all searching the same depths at once
+#define HELPER_SCHEDULES 20
+const unsigned int helper_skip_size[HELPER_SCHEDULES] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+const unsigned int helper_skip_phase[HELPER_SCHEDULES] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
 int futility_margin[64];
 int reverse_futility_margin[64];
 
-int type2collision;
-
 void init_search() {
     // Get tuning parameters
     auto& params = TuningParameters::instance();
@@ -80,9 +85,198 @@ inline Move MovePicker::operator++() {
     return moves[visit_count++];
 }
 
+// Only the low 22 bits (squares, flags and pieces) identify a move. Everything has to match
+// since a stale hash move or killer with a different piece moved must not hide the real one
+inline bool same_move(Move a, Move b) {
+    return ((a.get_raw_data() ^ b.get_raw_data()) & 0x3FFFFF) == 0;
+}
+
+StagedMovePicker::StagedMovePicker(Board& b, HashMove hash_move, Move* killer_moves,
+                                   unsigned int (*history_table)[64]) : board(b), killers(killer_moves),
+                                                                        history(history_table) {
+    tt_move = Move(hash_move.get_raw_data() & 0x3FFFFF);
+    stage = PICK_TT_MOVE;
+    index = 0;
+    num_bad_captures = 0;
+}
+
+inline bool StagedMovePicker::is_tt_move_or_killer(Move move) const {
+    return same_move(move, tt_move) || same_move(move, killers[0]) || same_move(move, killers[1]);
+}
+
+inline Move StagedMovePicker::pick_best(MoveList& moves, int from) {
+    int highest_index = from;
+    for (int i = from + 1; i < moves.size(); i++) {
+        if (moves[i].get_move_score() > moves[highest_index].get_move_score()) {
+            highest_index = i;
+        }
+    }
+    std::swap(moves[from], moves[highest_index]);
+    return moves[from];
+}
 
-Search::Search(Board b, TT& t, OpeningBook& ob, TimeHandler& th) : board(b), tt(t), opening_book(ob), time_handler(th) {
+bool StagedMovePicker::next(Move& move) {
+    switch (stage) {
+        case PICK_TT_MOVE:
+            stage = PICK_INIT_CAPTURES;
+            if (tt_move.get_raw_data() && board.is_legal_move(tt_move)) {
+                move = tt_move;
+                return true;
+            }
+            // fallthrough
+
+        case PICK_INIT_CAPTURES:
+            board.generate_moves<CAPTURES_ONLY>(captures);
+            for (auto it = captures.begin(); it != captures.end(); ++it) {
+                // MVV-LVA: most valuable victim first, least valuable attacker breaking ties
+                unsigned int score = 512 + 16 * (PIECE_PAWN + 1 - it->get_piece_captured()) + it->get_piece_moved();
+                if (it->get_special_flag() == MOVE_PROMOTION && it->get_promote_to() == PROMOTE_TO_QUEEN) {
+                    score += 16;
+                }
+                it->set_move_score(score);
+            }
+            index = 0;
+            stage = PICK_GOOD_CAPTURES;
+            // fallthrough
+
+        case PICK_GOOD_CAPTURES:
+            while (index < captures.size()) {
+                Move capture = pick_best(captures, index++);
+                if (same_move(capture, tt_move)) {
+                    continue;
+                }
+                // Losing captures are kept at the front of the list, behind the read index, for the last stage
+                if (Board::mvv_lva(capture) < 0 && board.static_exchange_eval(capture) < 0) {
+                    captures[num_bad_captures++] = capture;
+                    continue;
+                }
+                move = capture;
+                return true;
+            }
+            index = 0;
+            stage = PICK_KILLERS;
+            // fallthrough
+
+        case PICK_KILLERS:
+            while (index < 2) {
+                Move killer = killers[index++];
+                if (killer.get_raw_data() && !same_move(killer, tt_move) && !killer.is_capture() &&
+                    board.is_legal_move(killer)) {
+                    move = killer;
+                    return true;
+                }
+            }
+            stage = PICK_INIT_QUIETS;
+            // fallthrough
+
+        case PICK_INIT_QUIETS:
+            board.generate_moves<QUIETS_ONLY>(quiets);
+            for (auto it = quiets.begin(); it != quiets.end(); ++it) {
+                unsigned int score = 512;
+                unsigned int hist_lookup = history[it->get_from()][it->get_to()];
+                if (USE_HIST_HEURISTIC && hist_lookup) {
+                    score += bitscan_reverse(hist_lookup); // Takes a base2 log of hist_lookup
+                }
+                if (it->get_special_flag() == MOVE_PROMOTION) {
+                    score += 105 - it->get_promote_to();
+                }
+                it->set_move_score(score);
+            }
+            index = 0;
+            stage = PICK_QUIETS;
+            // fallthrough
+
+        case PICK_QUIETS:
+            while (index < quiets.size()) {
+                Move quiet = pick_best(quiets, index++);
+                if (!is_tt_move_or_killer(quiet)) {
+                    move = quiet;
+                    return true;
+                }
+            }
+            index = 0;
+            stage = PICK_BAD_CAPTURES;
+            // fallthrough
+
+        case PICK_BAD_CAPTURES:
+            if (index < num_bad_captures) {
+                move = captures[index++];
+                return true;
+            }
+            stage = PICK_DONE;
+            // fallthrough
+
+        default:
+            return false;
+    }
+}
+
+
+Search::Search(Board b, TT& t, OpeningBook& ob, TimeHandler& th, unsigned int id) : board(b), tt(t), opening_book(ob),
+                                                                                    time_handler(th), thread_id(id) {
     nodes_searched = 0;
+    tt_collisions = 0;
+    eval_cache_probes = 0;
+    eval_cache_hits = 0;
+    eval_caches = nullptr;
+    eval_cache = nullptr;
+    num_threads = 1;
+}
+
+void Search::set_threads(unsigned int n) {
+    num_threads = std::min(std::max(n, 1U), (unsigned int) MAX_SEARCH_THREADS);
+}
+
+void Search::set_eval_caches(std::vector<EvalCache>& caches) {
+    eval_caches = &caches;
+    eval_cache = thread_id < caches.size() ? &caches[thread_id] : nullptr;
+}
+
+inline void Search::count_node() {
+    // Only this thread writes its counter, so a relaxed load/store pair is enough and avoids a locked add
+    nodes_searched.store(nodes_searched.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+bool Search::is_main_thread() const {
+    return thread_id == 0;
+}
+
+U64 Search::total_nodes() const {
+    U64 nodes = nodes_searched.load(std::memory_order_relaxed);
+    for (auto& helper : helpers) {
+        nodes += helper->nodes_searched.load(std::memory_order_relaxed);
+    }
+    return nodes;
+}
+
+int Search::cached_static_eval() {
+    if (!eval_cache) {
+        return board.static_eval();
+    }
+    // Counters are only written by this thread, like nodes_searched
+    eval_cache_probes.store(eval_cache_probes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    U64 key = board.get_z_key();
+    int eval;
+    if (eval_cache->probe(key, eval)) {
+        eval_cache_hits.store(eval_cache_hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return eval;
+    }
+    eval = board.static_eval();
+    eval_cache->store(key, eval);
+    return eval;
+}
+
+void Search::eval_cache_message() {
+    U64 probes = eval_cache_probes.load(std::memory_order_relaxed);
+    U64 hits = eval_cache_hits.load(std::memory_order_relaxed);
+    for (auto& helper : helpers) {
+        probes += helper->eval_cache_probes.load(std::memory_order_relaxed);
+        hits += helper->eval_cache_hits.load(std::memory_order_relaxed);
+    }
+    std::ostringstream buffer;
+    buffer << "info string eval cache hits " << hits << " of " << probes << " probes ("
+           << (probes ? hits * 100 / probes : 0) << "%)\n";
+    get_synced_cout().print(buffer.str());
 }
 
 template<bool use_history_heuristic>
@@ -173,14 +367,15 @@ std::vector<Move> Search::get_pv() {
     std::vector<Move> pv;
     while (true) {
         TT_result tt_result = tt.get(board.get_z_key());
-        if (!tt_result.is_hit || tt_result.tt_entry.hash_move.get_node_type() != NODE_EXACT ||
+        if (!tt_result.is_hit || tt_result.tt_entry.get_node_type() != NODE_EXACT ||
             board.has_repeated_once()) {
             break;
         }
-        Move m = tt_result.tt_entry.hash_move.to_move();
-        MoveList legal_moves;
-        board.generate_moves(legal_moves);
-        assert(legal_moves.contains(tt_result.tt_entry.hash_move.to_move()));
+        Move m = board.complete_move(tt_result.tt_entry.get_move());
+        // Helper threads write to the TT concurrently, so the entry may not belong to this position
+        if (!board.is_legal_move(m)) {
+            break;
+        }
         pv.push_back(m);
         board.make_move(m);
     }
@@ -202,14 +397,38 @@ std::string print_move_vector(std::vector<Move> moves) {
 }
 
 
-void Search::store_pos_result(HashMove best_move, unsigned int depth, unsigned int node_type, int score,
-                              unsigned int ply_from_root) {
+// The TT keeps scores in 16 bits. Mate scores are stored as the distance to mate from the stored position, so
+// they stay correct when it's reached at a different ply, and packed into the top TT_MATE_RANGE of the range
+#define TT_MATE_RANGE (MAXMATE - MINMATE)
+
+int score_to_tt(int score, unsigned int ply_from_root) {
     if (score >= MINMATE) {
-        score += ply_from_root; // MAXMATE - (distance from this position to mate)
+        int mate_distance = std::max(MAXMATE - score - (int) ply_from_root, 0);
+        return TT_SCORE_MAX - std::min(mate_distance, TT_MATE_RANGE);
     } else if (score <= -MINMATE) {
-        score -= ply_from_root; // -(MAXMATE - (distance from this position to mate)
+        int mate_distance = std::max(MAXMATE + score - (int) ply_from_root, 0);
+        return -TT_SCORE_MAX + std::min(mate_distance, TT_MATE_RANGE);
+    }
+    return std::min(std::max(score, -(TT_SCORE_MAX - TT_MATE_RANGE - 1)), TT_SCORE_MAX - TT_MATE_RANGE - 1);
+}
+
+int score_from_tt(int score, unsigned int ply_from_root) {
+    if (score >= TT_SCORE_MAX - TT_MATE_RANGE) {
+        return MAXMATE - (TT_SCORE_MAX - score) - ply_from_root;
+    } else if (score <= -(TT_SCORE_MAX - TT_MATE_RANGE)) {
+        return -MAXMATE + (TT_SCORE_MAX + score) + ply_from_root;
     }
-    tt.set(board.get_z_key(), best_move, depth, node_type, score);
+    return score;
+}
+
+void Search::store_pos_result(HashMove best_move, unsigned int depth, unsigned int node_type, int score,
+                              unsigned int ply_from_root, int static_eval) {
+    if (static_eval != INT32_MIN) {
+        static_eval = std::min(std::max(static_eval, -TT_SCORE_MAX), TT_SCORE_MAX);
+    } else {
+        static_eval = TT_NO_EVAL;
+    }
+    tt.set(board.get_z_key(), best_move, depth, node_type, score_to_tt(score, ply_from_root), static_eval);
 }
 
 
@@ -231,15 +450,11 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
     // Check for hits on the TT
     const TT_result tt_result = tt.get(board.get_z_key());
 
-    if (tt_result.is_hit && tt_result.tt_entry.hash_move.get_depth() >= depth) {
+    if (tt_result.is_hit && tt_result.tt_entry.get_depth() >= depth) {
 
-        int score = tt_result.tt_entry.score;
-        unsigned int node_type = tt_result.tt_entry.hash_move.get_node_type();
-        if (score >= MINMATE) {
-            score -= ply_from_root; // This gets MAXMATE - (distance between mate and root)
-        } else if (score <= -MINMATE) {
-            score += ply_from_root; // This gets -(MAXMATE - (distance between mate and root))
-        }
+        // This gets +-(MAXMATE - (distance between mate and root)) for mate scores
+        int score = score_from_tt(tt_result.tt_entry.get_score(), ply_from_root);
+        unsigned int node_type = tt_result.tt_entry.get_node_type();
 
         if (node_type == NODE_EXACT) {
             return score;
@@ -252,8 +467,8 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
         }
     }
 
-    if (tt_result.is_hit && tt_result.tt_entry.hash_move.get_raw_data() != 0) {
-        type2collision++;
+    if (tt_result.is_hit && tt_result.tt_entry.move != 0) {
+        tt_collisions++;
     }
 
     if (depth == 0) {
@@ -277,21 +492,14 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
     }
 
 
-    MoveList moves;
-    bool is_in_check;
-    board.generate_moves(moves, is_in_check);
-
-    // Check for checkmate and stalemate
-    if (moves.size() == 0) {
-        if (is_in_check) {
-            return -MAXMATE + ply_from_root;
-        } else {
-            return 0;
-        }
-    }
+    // Moves are generated lazily by the move picker, so checkmate and stalemate are detected after the move loop
+    const bool is_in_check = board.is_in_check();
 
 
     int static_eval = INT32_MIN; // For futility pruning and reverse futility pruning
+    if (tt_result.is_hit && tt_result.tt_entry.get_static_eval() != TT_NO_EVAL) {
+        static_eval = tt_result.tt_entry.get_static_eval();
+    }
 
     // Reverse Futility Pruning (Static Null Move Pruning)
     // If our position is so good that even with a margin, we're above beta, return early
@@ -303,7 +511,7 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
         
         // Get static evaluation (lazy - only compute once)
         if (static_eval == INT32_MIN) {
-            static_eval = board.static_eval();
+            static_eval = cached_static_eval();
         }
         // If static eval minus margin is still >= beta, position is too good
         if (static_eval - reverse_futility_margin[depth] >= beta) {
@@ -329,9 +537,8 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
     
 
     HashMove move_to_assign;
-    if (tt_result.is_hit) {
-        move_to_assign = tt_result.tt_entry.hash_move;
-        assert(move_to_assign.get_raw_data() != 0);
+    if (tt_result.is_hit && tt_result.tt_entry.move != 0) {
+        move_to_assign = board.complete_move(tt_result.tt_entry.get_move());
     }
     
     // Internal Iterative Reductions (IIR)
@@ -345,12 +552,11 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
         iir_reduction = search_params.iir_reduction;
     }
     
-    assign_move_scores<true>(moves, move_to_assign, &killer_moves[ply_from_root][0]);
-
     bool do_pvs = depth > 2;
 
 
-    MovePicker move_picker(moves);
+    StagedMovePicker move_picker(board, move_to_assign, &killer_moves[ply_from_root][0],
+                                 history_moves[board.get_current_turn()]);
     HashMove best_move;
 
     unsigned int node_type = NODE_UPPERBOUND;
@@ -358,42 +564,42 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
     // For tactical stability, do not reduce moves when in check
     const bool do_lmr = !is_in_check && depth > 2 && beta-alpha <= 1;
     int move_count = 0;
+    Move it;
 
-    if (USE_PV_SEARCH && do_pvs) {
-        int first_eval;
-        auto first_move = ++move_picker;
-        nodes_searched++;
+    while (move_picker.next(it)) {
+        int eval;
+        unsigned int effective_depth = depth;
         move_count++;
 
-        board.make_move(first_move);
-        first_eval = -negamax(depth - 1, -beta, -alpha, ply_from_root + 1, ply_extended, true);
-        board.unmake_move();
+        // The first move is searched with the full window
+        if (USE_PV_SEARCH && do_pvs && move_count == 1) {
+            count_node();
 
-        if (first_eval >= beta) {
-            best_move = first_move;
-            assert(best_move.get_raw_data() != 0);
-            store_pos_result(best_move, depth, NODE_LOWERBOUND, beta, ply_from_root);
-            
-            // Only register quiet moves (non-captures, non-promotions)
-            if (!first_move.is_capture() && first_move.get_special_flag() != MOVE_PROMOTION) {
-                register_killers(ply_from_root, first_move);
-                register_history_move(depth, first_move);
+            board.make_move(it);
+            eval = -negamax(depth - 1, -beta, -alpha, ply_from_root + 1, ply_extended, true);
+            board.unmake_move();
+
+            if (eval >= beta) {
+                best_move = it;
+                assert(best_move.get_raw_data() != 0);
+                store_pos_result(best_move, depth, NODE_LOWERBOUND, beta, ply_from_root, static_eval);
+
+                // Only register quiet moves (non-captures, non-promotions)
+                if (!it.is_capture() && it.get_special_flag() != MOVE_PROMOTION) {
+                    register_killers(ply_from_root, it);
+                    register_history_move(depth, it);
+                }
+
+                return beta;
             }
-            
-            return beta;
-        }
-        if (first_eval > alpha) {
-            node_type = NODE_EXACT;
-            best_move = first_move;
-            alpha = first_eval;
+            if (eval > alpha) {
+                node_type = NODE_EXACT;
+                best_move = it;
+                alpha = eval;
+            }
+            continue;
         }
-    }
 
-    while (!move_picker.finished()) {
-        int eval;
-        unsigned int effective_depth = depth;
-        auto it = ++move_picker;
-        move_count++;
         // Look up reduction from table, clamping to table bounds
         unsigned int depth_reduction_value = lmr_table[std::min(depth, 63U)][std::min(move_count, 63)] + iir_reduction;
 
@@ -411,7 +617,7 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
             
             // Get static evaluation (lazy - only compute once)
             if (static_eval == INT32_MIN) {
-                static_eval = board.static_eval();
+                static_eval = cached_static_eval();
             }
             
             // If static eval + margin can't beat alpha, skip this move
@@ -429,7 +635,7 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
             continue;
         }
 
-        nodes_searched++;
+        count_node();
 
         effective_depth = determine_depth(effective_depth, depth_reduction_value, it, do_lmr);
 
@@ -440,7 +646,7 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
         if (eval >= beta) {
             best_move = it;
             assert(best_move.get_raw_data() != 0);
-            store_pos_result(best_move, depth, NODE_LOWERBOUND, beta, ply_from_root);
+            store_pos_result(best_move, depth, NODE_LOWERBOUND, beta, ply_from_root, static_eval);
             
             // Only register quiet moves (non-captures, non-promotions)
             if (!it.is_capture() && it.get_special_flag() != MOVE_PROMOTION) {
@@ -457,10 +663,19 @@ int Search::negamax(unsigned int depth, int alpha, int beta, unsigned int ply_fr
         }
     }
 
+    // Check for checkmate and stalemate
+    if (move_count == 0) {
+        if (is_in_check) {
+            return -MAXMATE + ply_from_root;
+        } else {
+            return 0;
+        }
+    }
+
 
     // Write search data to transposition table
     assert(best_move.get_raw_data() != 0 || node_type == NODE_UPPERBOUND);
-    store_pos_result(best_move, depth, node_type, alpha, ply_from_root);
+    store_pos_result(best_move, depth, node_type, alpha, ply_from_root, static_eval);
 
     return alpha;
 }
@@ -534,7 +749,7 @@ int Search::quiescence_search(unsigned int ply_from_horizon, int alpha, int beta
         }
     }
     
-    int stand_pat = board.static_eval();
+    int stand_pat = cached_static_eval();
     if (ply_from_horizon >= 5) {
         return stand_pat;
     }
@@ -573,7 +788,7 @@ int Search::quiescence_search(unsigned int ply_from_horizon, int alpha, int beta
             continue;
         }
 
-        nodes_searched++;
+        count_node();
         board.make_move(it);
         eval = -quiescence_search(ply_from_horizon + 1, -beta, -alpha, ply_from_root + 1);
         board.unmake_move();
@@ -591,11 +806,15 @@ int Search::quiescence_search(unsigned int ply_from_horizon, int alpha, int beta
 }
 
 void Search::log_search_info(int depth, int eval, bool book_move) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - search_start);
+    U64 nodes = total_nodes();
     std::ostringstream buffer;
     buffer << "info ";
     buffer << "score cp " << eval;
     buffer << " depth " << depth;
-    buffer << " nodes " << nodes_searched;
+    buffer << " nodes " << nodes;
+    buffer << " time " << elapsed.count();
+    buffer << " nps " << nodes * 1000 / (elapsed.count() + 1);
     if (!book_move) {
         auto pv = get_pv();
         if (pv.size() > 0) buffer << " pv " << print_move_vector(pv);
@@ -606,19 +825,55 @@ void Search::log_search_info(int depth, int eval, bool book_move) {
 
 void Search::search_finished_message(Move best_move, int depth, int eval, bool book_move) {
     log_search_info(depth, eval, book_move);
+    if (!book_move && eval_cache) {
+        eval_cache_message();
+    }
     std::ostringstream buffer;
     buffer << "bestmove " << move_to_str(best_move, true);
     buffer << '\n';
     get_synced_cout().print(buffer.str());
 }
 
+Move Search::finish_search(Move best_move, int depth, int eval, bool book_move) {
+    // Only the main thread talks to the GUI and owns the timer
+    if (is_main_thread()) {
+        search_finished_message(best_move, depth, eval, book_move);
+        time_handler.stop();
+    }
+    return best_move;
+}
+
+void Search::start_helpers(unsigned int max_depth) {
+    for (unsigned int i = 1; i < num_threads; i++) {
+        helpers.push_back(std::make_unique<Search>(board, tt, opening_book, time_handler, i));
+        if (eval_caches) {
+            helpers.back()->set_eval_caches(*eval_caches);
+        }
+    }
+    for (auto& helper : helpers) {
+        Search* h = helper.get();
+        helper_threads.emplace_back([h, max_depth]() { h->find_best_move(max_depth); });
+    }
+}
+
+void Search::stop_helpers() {
+    // Helpers poll the same should_end_search flag as the main thread
+    time_handler.stop();
+    for (auto& t : helper_threads) {
+        t.join();
+    }
+    helper_threads.clear();
+    helpers.clear();
+}
+
 
 Move Search::find_best_move(unsigned int max_depth = MAX_DEPTH) {
     max_depth = std::min(max_depth, (unsigned int) MAX_DEPTH);
     board.hash();
-    tt.increment_age();
-    type2collision = 0;
+    tt_collisions = 0;
     nodes_searched = 0;
+    eval_cache_probes = 0;
+    eval_cache_hits = 0;
 
     // Clear killers
     for (int i = 0; i < MAX_DEPTH; i++) {
@@ -634,15 +889,27 @@ Move Search::find_best_move(unsigned int max_depth = MAX_DEPTH) {
         }
     }
 
+    if (!is_main_thread()) {
+        return iterative_deepening(max_depth);
+    }
+
+    tt.new_search();
+    search_start = std::chrono::steady_clock::now();
     time_handler.start();
+    start_helpers(max_depth);
+
+    Move best_move = iterative_deepening(max_depth);
 
+    stop_helpers();
+    return best_move;
+}
+
+Move Search::iterative_deepening(unsigned int max_depth) {
     // Check opening_book
-    if (USE_BOOK && opening_book.can_use_book() && board.get_reg_starting_pos()) {
+    if (is_main_thread() && USE_BOOK && opening_book.can_use_book() && board.get_reg_starting_pos()) {
         Move book_move = opening_book.request(board.get_move_stack());
         if (!book_move.is_illegal()) {
-            time_handler.stop();
-            search_finished_message(book_move, 0, 0, true);
-            return book_move;
+            return finish_search(book_move, 0, 0, true);
         }
     }
 
@@ -655,8 +922,7 @@ Move Search::find_best_move(unsigned int max_depth = MAX_DEPTH) {
 
     // Don't bother searching if there's one legal move
     if (moves.size() == 1) {
-        search_finished_message(moves[0], 0, 0);
-        return moves[0];
+        return finish_search(moves[0], 0, 0);
     }
 
     int expected_eval = 0;
@@ -665,9 +931,18 @@ Move Search::find_best_move(unsigned int max_depth = MAX_DEPTH) {
     auto& search_params = TuningParameters::instance();
 
     // Iterative deepening loop
-    int depth;
+    unsigned int depth;
     for (depth = 1; depth <= max_depth; depth++) {
 
+        // Helpers skip depths by their own schedule so that threads are desynchronized
+        // (never the last one, so every thread searches something)
+        if (!is_main_thread() && depth < max_depth) {
+            unsigned int schedule = (thread_id - 1) % HELPER_SCHEDULES;
+            if ((depth + helper_skip_phase[schedule]) / helper_skip_size[schedule] % 2) {
+                continue;
+            }
+        }
+
         HashMove best_move_temp;
         best_move_temp = best_move;
 
@@ -709,16 +984,14 @@ Move Search::find_best_move(unsigned int max_depth = MAX_DEPTH) {
             if (USE_PV_SEARCH && do_pvs) {
                 int first_eval;
                 auto first_move = ++move_picker;
-                nodes_searched++;
+                count_node();
                 move_count++;
 
                 board.make_move(first_move);
                 try {
                     first_eval = -negamax(depth - 1, -beta, -alpha, 1, 0, true);
                 } catch (SearchTimeout& e) {
-                    search_finished_message(best_move, depth - 1, max_eval);
-                    time_handler.stop();
-                    return best_move;
+                    return finish_search(best_move, depth - 1, max_eval);
                 }
                 board.unmake_move();
 
@@ -750,7 +1023,7 @@ Move Search::find_best_move(unsigned int max_depth = MAX_DEPTH) {
                 // Look up reduction from table, clamping to table bounds
                 unsigned int depth_reduction_value = lmr_table[std::min((unsigned int)depth, 63U)][std::min(move_count, 63)];
 
-                nodes_searched++;
+                count_node();
                 board.make_move(it);
 
                 effective_depth = determine_depth(effective_depth, depth_reduction_value, it, do_lmr);
@@ -766,9 +1039,7 @@ Move Search::find_best_move(unsigned int max_depth = MAX_DEPTH) {
                     } else {
                         m = local_best_move;
                     }
-                    search_finished_message(m, depth - 1, max_eval);
-                    time_handler.stop();
-                    return m;
+                    return finish_search(m, depth - 1, max_eval);
                 }
                 board.unmake_move();
 
@@ -828,19 +1099,17 @@ Move Search::find_best_move(unsigned int max_depth = MAX_DEPTH) {
         store_pos_result(h_best_move, depth, NODE_EXACT, max_eval, 0);
 
         // If we've found the shortest possible checkmate, exit early
-        if (max_eval >= MINMATE && MAXMATE - max_eval <= depth) {
-            search_finished_message(best_move, depth, max_eval);
-            time_handler.stop();
-            return best_move;
+        if (max_eval >= MINMATE && MAXMATE - max_eval <= (int) depth) {
+            return finish_search(best_move, depth, max_eval);
         }
 
         // Send this iteration's info to the gui
-        log_search_info(depth, max_eval);
+        if (is_main_thread()) {
+            log_search_info(depth, max_eval);
+        }
     }
 
-    search_finished_message(best_move, max_depth, max_eval);
-    time_handler.stop();
-    return best_move;
+    return finish_search(best_move, max_depth, max_eval);
 }
 
 
@@ -851,6 +1120,11 @@ long Search::perft(unsigned int depth) {
         return 1;
     }
 
+    // Bulk counting: the leaves are just the legal moves, so count them without making any
+    if (depth == 1) {
+        return board.calculate_mobility<ALL_MOVES>();
+    }
+
     long nodes = 0;
 
     MoveList moves;
@@ -865,6 +1139,40 @@ long Search::perft(unsigned int depth) {
     return nodes;
 }
 
+std::vector<long> Search::split_perft(MoveList& moves, unsigned int depth, PerftTT* perft_tt) {
+    std::vector<long> counts(moves.size());
+    std::atomic<int> next_move(0);
+
+    // Root moves are few and of very different sizes, so threads claim them one at a time rather than in fixed shares
+    for (unsigned int i = 1; i < std::min(num_threads, (unsigned int) moves.size()); i++) {
+        helpers.push_back(std::make_unique<Search>(board, tt, opening_book, time_handler, i));
+    }
+    for (auto& helper : helpers) {
+        Search* h = helper.get();
+        helper_threads.emplace_back([h, &moves, depth, perft_tt, &next_move, &counts]() {
+            h->split_perft_worker(moves, depth, perft_tt, next_move, counts);
+        });
+    }
+    split_perft_worker(moves, depth, perft_tt, next_move, counts);
+
+    for (auto& t : helper_threads) {
+        t.join();
+    }
+    helper_threads.clear();
+    helpers.clear();
+    return counts;
+}
+
+void Search::split_perft_worker(MoveList& moves, unsigned int depth, PerftTT* perft_tt,
+                                std::atomic<int>& next_move, std::vector<long>& counts) {
+    int i;
+    while ((i = next_move.fetch_add(1, std::memory_order_relaxed)) < (int) moves.size()) {
+        board.make_move(moves[i]);
+        counts[i] = perft_tt ? hash_perft(depth - 1, *perft_tt) : perft(depth - 1);
+        board.unmake_move();
+    }
+}
+
 long Search::sort_perft(unsigned int depth) {
 
     if (depth == 0) {
@@ -891,26 +1199,18 @@ long Search::sort_perft(unsigned int depth) {
     return nodes;
 }
 
-long Search::hash_perft(unsigned int depth) {
-    tt.clear();
-    long result = hash_perft_internal(depth);
-    tt.clear();
-    return result;
-}
-
-long Search::hash_perft_internal(unsigned int depth) {
+long Search::hash_perft(unsigned int depth, PerftTT& perft_tt) {
     if (depth == 0) {
         return 1;
     }
 
-    TT_result tt_result = tt.get(board.get_z_key());
+    if (depth == 1) {
+        return board.calculate_mobility<ALL_MOVES>();
+    }
 
-    if (tt_result.is_hit && tt_result.tt_entry.hash_move.get_depth() == depth) {
-//        if (tt_result.sanity_check != board.tt_sanity_check()) {
-//            std::cout << "Type 1 collision occured" << std::endl;
-//        }
-//        std::cout << tt_result.sanity_check << ' ' << board.tt_sanity_check() << '\n';
-        return tt_result.tt_entry.score;
+    U64 cached_nodes;
+    if (perft_tt.probe(board.get_z_key(), depth, cached_nodes)) {
+        return (long) cached_nodes;
     }
 
     long nodes = 0;
@@ -921,12 +1221,11 @@ long Search::hash_perft_internal(unsigned int depth) {
 
     for (auto it = moves.begin(); it != moves.end(); ++it) {
         board.make_move(*it);
-        nodes += hash_perft_internal(depth - 1);
+        nodes += hash_perft(depth - 1, perft_tt);
         board.unmake_move();
     }
 
-    // Write data to transposition table
-    tt.set(board.get_z_key(), Move(), depth, NODE_EXACT, (int) nodes);
+    perft_tt.store(board.get_z_key(), depth, nodes);
 
     return nodes;
 }
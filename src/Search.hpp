@@ -14,7 +14,10 @@
 #include "Opening_book.hpp"
 #include "Time_handler.hpp"
 
+#include <memory>
+
 #define MAX_DEPTH 64
+#define MAX_SEARCH_THREADS 256
 #define MAXMATE 2000000
 #define MINMATE 1999000
 #define PRUNE_MOVE_SCORE 0
@@ -51,6 +54,38 @@ public:
     Move operator++();
 };
 
+enum PickerStage {
+    PICK_TT_MOVE,
+    PICK_INIT_CAPTURES,
+    PICK_GOOD_CAPTURES,
+    PICK_KILLERS,
+    PICK_INIT_QUIETS,
+    PICK_QUIETS,
+    PICK_BAD_CAPTURES,
+    PICK_DONE,
+};
+
+// Move picker for the main search. Moves are generated and scored one stage at a time:
+// hash move, captures that don't lose material (MVV-LVA, SEE only when picked), killers,
+// quiets by history, then the losing captures. A cutoff early on skips generating the rest.
+class StagedMovePicker {
+private:
+    Board& board;
+    Move tt_move;
+    Move* killers;
+    unsigned int (*history)[64];
+    MoveList captures, quiets;
+    int stage, index, num_bad_captures;
+
+    bool is_tt_move_or_killer(Move move) const;
+
+    static Move pick_best(MoveList& moves, int from);
+public:
+    StagedMovePicker(Board& b, HashMove hash_move, Move* killer_moves, unsigned int (*history_table)[64]);
+
+    bool next(Move& move);
+};
+
 
 struct SearchTimeout : public std::exception {
 };
@@ -66,10 +101,51 @@ private:
     Move killer_moves[MAX_DEPTH][2];
     unsigned int history_moves[2][64][64];
 
-    unsigned int nodes_searched;
+    // Read by the main thread while helpers are searching, hence atomic
+    std::atomic<U64> nodes_searched;
+    unsigned int tt_collisions;
+
+    // Eval caches of all the threads, owned by the engine so they carry over from one search to the next
+    // eval_cache is this thread's, or nullptr to evaluate without caching
+    std::vector<EvalCache>* eval_caches;
+    EvalCache* eval_cache;
+    std::atomic<U64> eval_cache_probes, eval_cache_hits;
+
+    // Lazy SMP: thread 0 is the main thread, which owns the timer, prints output
+    // and spawns (num_threads - 1) helper searches that share the TT
+    unsigned int thread_id;
+    unsigned int num_threads;
+    std::vector<std::unique_ptr<Search>> helpers;
+    std::vector<std::thread> helper_threads;
+
+    std::chrono::steady_clock::time_point search_start;
+
+    void count_node();
+
+    bool is_main_thread() const;
+
+    void start_helpers(unsigned int max_depth);
+
+    void stop_helpers();
+
+    U64 total_nodes() const;
+
+    // Static eval of the current position, through this thread's eval cache
+    int cached_static_eval();
+
+    void eval_cache_message();
+
+    Move finish_search(Move best_move, int depth, int eval, bool book_move = false);
+
+    Move iterative_deepening(unsigned int max_depth);
 public:
 
-    Search(Board b, TT& t, OpeningBook& ob, TimeHandler& th);
+    Search(Board b, TT& t, OpeningBook& ob, TimeHandler& th, unsigned int id = 0);
+
+    void set_threads(unsigned int n);
+
+    // Cache static evals in caches[thread_id], a helper uses the entry of its own thread id
+    void set_eval_caches(std::vector<EvalCache>& caches);
 
     template <bool use_history_heuristic = false>
     void assign_move_scores(MoveList &moves, HashMove hash_move, Move killers[2]);
@@ -80,7 +156,7 @@ public:
     std::vector<Move> get_pv();
 
     void store_pos_result(HashMove best_move, unsigned int depth, unsigned int node_type, int score,
-                          unsigned int ply_from_root);
+                          unsigned int ply_from_root, int static_eval = INT32_MIN);
 
     void log_search_info(int depth, int eval, bool book_move = false);
 
@@ -98,11 +174,18 @@ public:
 
     long perft(unsigned int depth);
 
-    long sort_perft(unsigned int depth);
+    // Perft of each root move in moves, split over num_threads threads that each take the next unclaimed move
+    // on their own copy of the board; the counts are returned in the order of moves
+    // With a perft_tt the threads share it through hash_perft
+    std::vector<long> split_perft(MoveList& moves, unsigned int depth, PerftTT* perft_tt = nullptr);
+
+    void split_perft_worker(MoveList& moves, unsigned int depth, PerftTT* perft_tt,
+                            std::atomic<int>& next_move, std::vector<long>& counts);
 
-    long hash_perft(unsigned int depth);
+    long sort_perft(unsigned int depth);
 
-    long hash_perft_internal(unsigned int depth);
+    // Perft that looks up and stores subtree counts in perft_tt, which may be shared with other threads
+    long hash_perft(unsigned int depth, PerftTT& perft_tt);
 
     long capture_perft(unsigned int depth);
 
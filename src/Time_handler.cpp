@@ -55,11 +55,13 @@ bool TimeHandler::should_stop() {
 }
 
 void TimeHandler::stop() {
+    // May be called more than once per search (e.g. by the main thread and again when joining helpers)
     should_end_search = true;
-    assert(t);
-    if (t->joinable()) {
-        t->join();
+    if (t) {
+        if (t->joinable()) {
+            t->join();
+        }
+        delete t;
+        t = nullptr;
     }
-    delete t;
-    t = nullptr;
 }
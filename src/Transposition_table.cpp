@@ -7,15 +7,21 @@
 //
 
 #include "Transposition_table.hpp"
+#include "Zobrist.hpp"
 
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
 
-U64 constexpr TT_SIZE() {
-    return C64(1) << TT_EXP_2_SIZE;
-}
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-U64 constexpr TT_LOOKUP_MASK() {
-    return TT_SIZE() - 1;
-}
 
 void HashMove::operator=(Move move) {
     move_data = move.get_raw_data() & 0x3FFFFF;
@@ -25,79 +31,208 @@ bool HashMove::operator==(Move move) {
     return (move_data & 0x3FFFFF) == (move.get_raw_data() & 0x3FFFFF);
 }
 
-unsigned int HashMove::get_depth() const {
-    return (move_data >> 22) & 0x3F;
+const Move HashMove::to_move() const {
+    return Move(move_data);
+}
+
+Move TT_entry::get_move() const {
+    return Move(move);
 }
 
-unsigned int HashMove::get_node_type() const {
-    return (move_data >> 28) & 0xF;
+unsigned int TT_entry::get_depth() const {
+    return depth;
 }
 
-void HashMove::set_depth(unsigned int depth) {
-    move_data &= ~(0x3F << 22);
-    move_data |= (depth & 0x3F) << 22;
+unsigned int TT_entry::get_node_type() const {
+    return gen_bound & 0x3;
 }
 
-void HashMove::set_node_type(unsigned int node_type) {
-    move_data &= ~(0xF << 28);
-    move_data |= (node_type & 0xF) << 28;
+unsigned int TT_entry::get_generation() const {
+    return gen_bound >> 2;
 }
 
-const Move HashMove::to_move() const {
-    return Move(move_data);
+int TT_entry::get_score() const {
+    return score;
 }
 
-unsigned int upper_bits_to_u32(U64 input) {
-    return (input >> 32);
+int TT_entry::get_static_eval() const {
+    return static_eval;
 }
 
-TT::TT() {
+// The word is the first 8 bytes of the entry, copying it whole keeps get() free of shifts and partial stores
+uint64_t TT_entry::get_word() const {
+    uint64_t word;
+    memcpy(&word, this, sizeof(word));
+    return word;
+}
+
+TT_entry TT_entry::from_word(uint64_t word, int16_t static_eval) {
+    TT_entry entry;
+    memcpy(&entry, &word, sizeof(word));
+    entry.static_eval = static_eval;
+    return entry;
+}
+
+uint16_t upper_bits_to_u16(U64 input) {
+    return (input >> 48);
+}
+
+TT::TT(size_t mb) : hash_table(nullptr), num_buckets(0), allocated_bytes(0), page_size(0),
+                    huge_pages_requested(false), num_threads(1), generation(0) {
     // Constructor, allocate the hash_table
-    hash_table = new bucket[TT_SIZE()];
-    Move move;
-    for (int i = 0; i < TT_SIZE(); i++) {
-        assert((hash_table + i)->entries[0].hash_move == move);
-        assert((hash_table + i)->entries[0].key == 0);
-        assert((hash_table + i)->entries[0].score == 0);
-    }
+    resize(mb);
 }
 
 TT::~TT() {
     // Delete hash_table
-    delete[] hash_table;
+    deallocate();
+}
+
+#if defined(__linux__)
+bool transparent_huge_pages_enabled() {
+    // The active mode is the bracketed one, e.g. "always [madvise] never"
+    std::ifstream mode("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string line;
+    std::getline(mode, line);
+    return line.find("[always]") != std::string::npos || line.find("[madvise]") != std::string::npos;
+}
+
+// Size of the pages MAP_HUGETLB hands out, the "Hugepagesize" line of /proc/meminfo. 0 if it can't be read
+size_t hugetlb_page_size() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    while (std::getline(meminfo, line)) {
+        if (line.compare(0, 13, "Hugepagesize:") == 0) {
+            return std::strtoull(line.c_str() + 13, nullptr, 10) << 10;
+        }
+    }
+    return 0;
+}
+#endif
+
+void TT::allocate(size_t bytes) {
+    huge_pages_requested = false;
+    // Round up to whole large pages, the tail past the last bucket is never touched
+    allocated_bytes = (bytes + TT_LARGE_PAGE_SIZE - 1) & ~(TT_LARGE_PAGE_SIZE - 1);
+#if defined(__linux__)
+#if TT_USE_HUGETLB
+    // Only succeeds if huge pages were reserved by the admin, otherwise it fails straight away
+    // The default huge page size isn't always 2 MB (1 GB, or 512 MB on 64K page arm64 kernels), and the mapping has
+    // to be a whole number of them
+    size_t hugetlb_size = hugetlb_page_size();
+    if (hugetlb_size) {
+        size_t hugetlb_bytes = (bytes + hugetlb_size - 1) / hugetlb_size * hugetlb_size;
+        void* memory = mmap(nullptr, hugetlb_bytes, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            hash_table = static_cast<bucket*>(memory);
+            allocated_bytes = hugetlb_bytes;
+            page_size = hugetlb_size;
+            return;
+        }
+    }
+#endif
+    // Map an extra large page so the table can start on a large page boundary, and hand back the slack
+    size_t padded_bytes = allocated_bytes + TT_LARGE_PAGE_SIZE;
+    void* mapping = mmap(nullptr, padded_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        allocated_bytes = 0;
+        throw std::bad_alloc();
+    }
+    char* start = static_cast<char*>(mapping);
+    char* aligned = reinterpret_cast<char*>(((uintptr_t) start + TT_LARGE_PAGE_SIZE - 1) & ~(TT_LARGE_PAGE_SIZE - 1));
+    if (aligned != start) {
+        munmap(start, aligned - start);
+    }
+    size_t tail = (start + padded_bytes) - (aligned + allocated_bytes);
+    if (tail) {
+        munmap(aligned + allocated_bytes, tail);
+    }
+    // Transparent huge pages, works with the default "madvise" setting. This is only a hint: the kernel backs the
+    // table with huge pages as it's faulted in when it can, and falls back to normal pages when memory is fragmented
+    hash_table = reinterpret_cast<bucket*>(aligned);
+    huge_pages_requested = madvise(aligned, allocated_bytes, MADV_HUGEPAGE) == 0 && transparent_huge_pages_enabled();
+    page_size = sysconf(_SC_PAGESIZE);
+#else
+    // Start on a large page boundary like the mmap path, new[] would only align to alignof(bucket)
+    hash_table = static_cast<bucket*>(aligned_alloc(TT_LARGE_PAGE_SIZE, allocated_bytes));
+    if (!hash_table) {
+        allocated_bytes = 0;
+        throw std::bad_alloc();
+    }
+    page_size = 4096;
+#endif
+}
+
+void TT::deallocate() {
+    if (!hash_table) {
+        return;
+    }
+#if defined(__linux__)
+    munmap(hash_table, allocated_bytes);
+#else
+    free(hash_table);
+#endif
+    hash_table = nullptr;
+    allocated_bytes = 0;
+}
+
+inline bucket* TT::get_bucket(U64 key) const {
+    // Map the lower 32 bits of the key onto [0, num_buckets) so any table size can be used
+    // The upper 16 bits are kept as the entry key
+    return hash_table + (((key & 0xFFFFFFFF) * num_buckets) >> 32);
+}
+
+inline unsigned int TT::relative_age(const TT_entry& entry) const {
+    // Number of searches since the entry was written, wrapping with the generation counter
+    return (generation - entry.get_generation()) & ((1 << TT_GENERATION_BITS) - 1);
+}
+
+inline TT_entry TT::load_entry(const bucket* b, int index) {
+    // Relaxed atomics compile to plain moves on x86, so this costs nothing over a racy read
+    return TT_entry::from_word(b->words[index].load(std::memory_order_relaxed),
+                               b->static_evals[index].load(std::memory_order_relaxed));
+}
+
+inline void TT::store_entry(bucket* b, int index, const TT_entry& entry) {
+    b->static_evals[index].store(entry.static_eval, std::memory_order_relaxed);
+    b->words[index].store(entry.get_word(), std::memory_order_relaxed);
 }
 
 TT_result TT::get(U64 key) const {
-    U64 lower_key = key & TT_LOOKUP_MASK();
-    unsigned int upper_key = upper_bits_to_u32(key);
-    bucket b = *(hash_table + lower_key);
+    uint16_t upper_key = upper_bits_to_u16(key);
+    const bucket* b = get_bucket(key);
     for (int i = 0; i < BUCKET_SIZE; i++) {
-        TT_entry tt_entry = b.entries[i];
-        if (tt_entry.key == upper_key) {
-            return TT_result{tt_entry, true};
+        uint64_t word = b->words[i].load(std::memory_order_relaxed);
+        // Key in the low 16 bits, depth in bits 48-55 (0 for an empty entry)
+        if ((uint16_t) word == upper_key && (word >> 48) & 0xFF) {
+            return TT_result{TT_entry::from_word(word, b->static_evals[i].load(std::memory_order_relaxed)), true};
         }
     }
     return TT_result{TT_entry(), false};
 }
 
 void TT::prefetch(U64 key) const {
-    U64 lower_key = key & TT_LOOKUP_MASK();
-    __builtin_prefetch(hash_table + lower_key, 1);
+    __builtin_prefetch(get_bucket(key), 1);
 }
 
-void set_tt_entry(TT_entry& entry, unsigned int upper_key, Move best_move, unsigned int depth, unsigned int node_type, int score) {
-    entry.key = upper_key;
-    entry.hash_move = best_move;
-    entry.hash_move.set_depth(depth);
-    entry.hash_move.set_node_type(node_type);
-    entry.score = score;
-    entry.age = 0;
-}
+void TT::set(U64 key, Move best_move, unsigned int depth, unsigned int node_type, int score, int static_eval) {
+    assert(depth > 0 && depth <= 0xFF);
+    assert(score >= -TT_SCORE_MAX && score <= TT_SCORE_MAX);
 
-void TT::set(U64 key, Move best_move, unsigned int depth, unsigned int node_type, int score) {
-    U64 lower_key = key & TT_LOOKUP_MASK();
-    unsigned int upper_key = upper_bits_to_u32(key);
-    bucket* b = hash_table + lower_key;
+    TT_entry new_entry;
+    new_entry.key = upper_bits_to_u16(key);
+    new_entry.move = best_move.get_raw_data() & 0xFFFF;
+    new_entry.score = score;
+    new_entry.static_eval = static_eval;
+    new_entry.depth = depth;
+    new_entry.gen_bound = (generation << 2) | node_type;
+
+    bucket* b = get_bucket(key);
+    TT_entry entries[BUCKET_SIZE];
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        entries[i] = load_entry(b, i);
+    }
 
     unsigned int min_depth = 20000;
     int min_index = -1;
@@ -106,78 +241,314 @@ void TT::set(U64 key, Move best_move, unsigned int depth, unsigned int node_type
     int oldest_index = 0;
 
     for (int i = 0; i < BUCKET_SIZE; i++) {
-        TT_entry& entry = b->entries[i];
-        unsigned int entry_depth = entry.hash_move.get_depth();
+        TT_entry& entry = entries[i];
+        unsigned int entry_depth = entry.get_depth();
 
         // Replace empty entries or entries with matching key
-        if (entry.key == upper_key || entry.hash_move.get_raw_data() == 0) {
-            set_tt_entry(entry, upper_key, best_move, depth, node_type, score);
+        if (entry.key == new_entry.key || entry_depth == 0) {
+            store_entry(b, i, new_entry);
             return;
         }
         // Save oldest entry index in case the above fails
-        if (entry.age > oldest) {
-            oldest = entry.age;
+        unsigned int age = relative_age(entry);
+        if (age > oldest) {
+            oldest = age;
             oldest_index = i;
         }
         // Save lowest depth search in the case the above fails
-        else if (entry_depth < min_depth && entry.hash_move.get_node_type() != NODE_EXACT) {
+        else if (entry_depth < min_depth && entry.get_node_type() != NODE_EXACT) {
             min_depth = entry_depth;
             min_index = i;
         }
     }
 
     if (oldest > 0) {
-        set_tt_entry(b->entries[oldest_index], upper_key, best_move, depth, node_type, score);
+        store_entry(b, oldest_index, new_entry);
         return;
     }
     if (min_index != -1) {
-        set_tt_entry(b->entries[min_index], upper_key, best_move, depth, node_type, score);
+        store_entry(b, min_index, new_entry);
         return;
     }
 
     // If none of the entries were replaceable it means they're all PV nodes
     for (int i = 0; i < BUCKET_SIZE; i++) {
-        assert(b->entries[0].hash_move.get_node_type() == NODE_EXACT);
-        assert(b->entries[1].hash_move.get_node_type() == NODE_EXACT);
-        assert(b->entries[2].hash_move.get_node_type() == NODE_EXACT);
-        assert(b->entries[3].hash_move.get_node_type() == NODE_EXACT);
+        assert(entries[i].get_node_type() == NODE_EXACT);
     }
 
     // PV node specific pass
     // since PV node must be replaced
     if (node_type == NODE_EXACT) {
         for (int i = 0; i < BUCKET_SIZE; i++) {
-            TT_entry& entry = b->entries[i];
-            if (entry.hash_move.get_node_type() != NODE_EXACT) {
-                set_tt_entry(entry, upper_key, best_move, depth, node_type, score);
-                return;
-            } else if (entry.age > 0) {
-                set_tt_entry(entry, upper_key, best_move, depth, node_type, score);
+            TT_entry& entry = entries[i];
+            if (entry.get_node_type() != NODE_EXACT || relative_age(entry) > 0) {
+                store_entry(b, i, new_entry);
                 return;
             }
         }
     }
 }
 
-void TT::increment_age() {
-    for (int i = 0; i < TT_SIZE(); i++) {
-        for (int j = 0; j < BUCKET_SIZE; j++) {
-            TT_entry& entry = (hash_table + i)->entries[j];
-            if (entry.hash_move.get_raw_data() != 0) {
-                entry.age++;
+void TT::new_search() {
+    generation = (generation + 1) & ((1 << TT_GENERATION_BITS) - 1);
+}
+
+
+void TT::clear() {
+    // All zero is an empty entry, so the table can just be memset. It's split into chunks of whole large pages
+    // zeroed by as many threads as the search is allowed to use
+    char* table = reinterpret_cast<char*>(hash_table);
+    size_t bytes = num_buckets * sizeof(bucket);
+    size_t num_chunks = (bytes + TT_CLEAR_CHUNK - 1) / TT_CLEAR_CHUNK;
+    unsigned int num_workers = std::max((size_t) 1, std::min((size_t) num_threads, num_chunks));
+
+    auto clear_chunks = [=](unsigned int worker) {
+        for (size_t chunk = worker; chunk < num_chunks; chunk += num_workers) {
+            size_t offset = chunk * TT_CLEAR_CHUNK;
+            memset(table + offset, 0, std::min((size_t) TT_CLEAR_CHUNK, bytes - offset));
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < num_workers; i++) {
+        workers.emplace_back(clear_chunks, i);
+    }
+    clear_chunks(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void TT::resize(size_t mb) {
+    mb = std::min(std::max(mb, (size_t) TT_MIN_MB), (size_t) TT_MAX_MB);
+
+    U64 new_size = ((U64) mb << 20) / sizeof(bucket);
+
+    if (new_size != num_buckets) {
+        // Free the old table first so peak memory use stays at one table
+        deallocate();
+        num_buckets = 0;
+        allocate(new_size * sizeof(bucket));
+        num_buckets = new_size;
+#if !defined(__linux__)
+        clear();
+#endif
+        // A fresh anonymous mapping is already zero, so there's nothing to clear and the pages
+        // get faulted in as the search first touches them rather than all up front
+        return;
+    }
+    clear();
+}
+
+void TT::set_threads(unsigned int threads) {
+    num_threads = std::max(threads, 1U);
+}
+
+size_t TT::size_mb() const {
+    return (num_buckets * sizeof(bucket)) >> 20;
+}
+
+size_t TT::get_page_size() const {
+    return page_size;
+}
+
+bool TT::get_huge_pages_requested() const {
+    return huge_pages_requested;
+}
+
+bool TT::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to open TT file: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<char> header_page(TT_FILE_HEADER_SIZE);
+    TT_file_header header = {};
+    header.magic = TT_FILE_MAGIC;
+    header.version = TT_FILE_VERSION;
+    header.bucket_bytes = sizeof(bucket);
+    header.num_buckets = num_buckets;
+    header.zobrist_seed = ZOBRIST_SEED;
+    header.header_bytes = TT_FILE_HEADER_SIZE;
+    header.generation = generation;
+    memcpy(header_page.data(), &header, sizeof(header));
+
+    file.write(header_page.data(), header_page.size());
+    file.write(reinterpret_cast<const char*>(hash_table), num_buckets * sizeof(bucket));
+    file.flush();
+    if (!file) {
+        std::cerr << "Failed to write TT file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TT::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open TT file: " << path << std::endl;
+        return false;
+    }
+
+    TT_file_header header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        std::cerr << "TT file is too short: " << path << std::endl;
+        return false;
+    }
+    if (header.magic != TT_FILE_MAGIC || header.version != TT_FILE_VERSION || header.bucket_bytes != sizeof(bucket)) {
+        std::cerr << "TT file was saved with a different entry format: " << path << std::endl;
+        return false;
+    }
+    if (header.zobrist_seed != ZOBRIST_SEED) {
+        std::cerr << "TT file was saved with different Zobrist keys: " << path << std::endl;
+        return false;
+    }
+    U64 max_buckets = ((U64) TT_MAX_MB << 20) / sizeof(bucket);
+    if (header.num_buckets == 0 || header.num_buckets > max_buckets) {
+        std::cerr << "TT file has an invalid size: " << path << std::endl;
+        return false;
+    }
+    if (header.header_bytes < sizeof(header)) {
+        std::cerr << "TT file has an invalid header: " << path << std::endl;
+        return false;
+    }
+    size_t bytes = header.num_buckets * sizeof(bucket);
+
+#if defined(__linux__)
+    // The buckets can only be mapped if they start on a page boundary of this kernel, otherwise read them in
+    if (header.header_bytes % sysconf(_SC_PAGESIZE) == 0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat file_stat;
+        if (fd == -1 || fstat(fd, &file_stat) == -1 || (U64) file_stat.st_size < header.header_bytes + bytes) {
+            if (fd != -1) {
+                close(fd);
             }
+            std::cerr << "TT file is too short: " << path << std::endl;
+            return false;
+        }
+        // Private mapping: writes from the search go to copies of the pages, never back to the file
+        void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, header.header_bytes);
+        close(fd);
+        if (memory == MAP_FAILED) {
+            std::cerr << "Failed to map TT file: " << path << std::endl;
+            return false;
         }
+        deallocate();
+        hash_table = static_cast<bucket*>(memory);
+        allocated_bytes = bytes;
+        page_size = sysconf(_SC_PAGESIZE); // File pages can't be transparent huge pages
+        huge_pages_requested = false;
+        num_buckets = header.num_buckets;
+        generation = header.generation & ((1 << TT_GENERATION_BITS) - 1);
+        return true;
     }
+#endif
+    // Read into a new table, keeping the current one until the read succeeded
+    bucket* old_table = hash_table;
+    size_t old_bytes = allocated_bytes;
+    size_t old_page_size = page_size;
+    bool old_huge_pages_requested = huge_pages_requested;
+    hash_table = nullptr;
+    try {
+        allocate(bytes);
+    } catch (std::bad_alloc& e) {
+        hash_table = old_table;
+        allocated_bytes = old_bytes;
+        page_size = old_page_size;
+        huge_pages_requested = old_huge_pages_requested;
+        std::cerr << "Not enough memory to load TT file: " << path << std::endl;
+        return false;
+    }
+    file.seekg(header.header_bytes);
+    bool complete = (bool) file.read(reinterpret_cast<char*>(hash_table), bytes);
+    if (complete) {
+        std::swap(hash_table, old_table);
+        std::swap(allocated_bytes, old_bytes);
+    } else {
+        page_size = old_page_size;
+        huge_pages_requested = old_huge_pages_requested;
+    }
+    deallocate();
+    hash_table = old_table;
+    allocated_bytes = old_bytes;
+    if (!complete) {
+        std::cerr << "TT file is too short: " << path << std::endl;
+        return false;
+    }
+    num_buckets = header.num_buckets;
+    generation = header.generation & ((1 << TT_GENERATION_BITS) - 1);
+    return true;
 }
 
 
-void TT::clear() {
-    memset(hash_table, 0, TT_SIZE() * sizeof(*hash_table));
-    Move move;
-    for (int i = 0; i < TT_SIZE(); i++) {
-        assert((hash_table + i)->entries[0].hash_move == move);
-        assert((hash_table + i)->entries[0].key == 0);
-        assert((hash_table + i)->entries[0].score == 0);
+EvalCache::EvalCache() : entries(new U64[EVAL_CACHE_ENTRIES]()) {
+}
+
+bool EvalCache::probe(U64 key, int& eval) const {
+    U64 entry = entries[key & (EVAL_CACHE_ENTRIES - 1)];
+    if ((entry ^ key) >> 16) {
+        return false;
     }
+    eval = static_cast<int16_t>(entry & 0xFFFF);
+    return true;
+}
+
+void EvalCache::clear() {
+    std::fill(entries.get(), entries.get() + EVAL_CACHE_ENTRIES, 0);
+}
+
+void EvalCache::store(U64 key, int eval) {
+    if (eval < INT16_MIN || eval > INT16_MAX) {
+        return;
+    }
+    entries[key & (EVAL_CACHE_ENTRIES - 1)] = (key & ~C64(0xFFFF)) | static_cast<uint16_t>(eval);
+}
+
+
+PerftTT::PerftTT(size_t mb) : num_buckets(0) {
+    resize(mb);
 }
 
+inline perft_bucket* PerftTT::get_bucket(U64 key) const {
+    // Same mapping as the search TT, the whole key is checked anyway
+    return &buckets[((key & 0xFFFFFFFF) * num_buckets) >> 32];
+}
+
+bool PerftTT::probe(U64 key, unsigned int depth, U64& nodes) const {
+    const perft_bucket* b = get_bucket(key);
+    for (int i = 0; i < 2; i++) {
+        U64 word = b->words[i].load(std::memory_order_relaxed);
+        if ((b->checks[i].load(std::memory_order_relaxed) ^ word) == key && (word & 0xFF) == depth) {
+            nodes = word >> 8;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerftTT::store(U64 key, unsigned int depth, U64 nodes) {
+    assert(depth > 0 && depth <= 0xFF);
+    if (nodes >> PERFT_COUNT_BITS) {
+        return;
+    }
+    perft_bucket* b = get_bucket(key);
+    U64 word = (nodes << 8) | depth;
+    int index = depth >= (b->words[0].load(std::memory_order_relaxed) & 0xFF) ? 0 : 1;
+    b->words[index].store(word, std::memory_order_relaxed);
+    b->checks[index].store(key ^ word, std::memory_order_relaxed);
+}
+
+void PerftTT::resize(size_t mb) {
+    // Free the old table first so peak memory use stays at one table
+    buckets.reset();
+    num_buckets = ((U64) std::min(mb, (size_t) TT_MAX_MB) << 20) / sizeof(perft_bucket);
+    if (num_buckets) {
+        // Value initialized, so every entry starts out with depth 0, which is never probed
+        buckets.reset(new perft_bucket[num_buckets]());
+    }
+}
+
+size_t PerftTT::size_mb() const {
+    return (num_buckets * sizeof(perft_bucket)) >> 20;
+}
@@ -10,18 +10,44 @@
 #define Transposition_table_hpp
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstring>
+#include <memory>
 
 #include "depend.hpp"
 #include "Data_structs.hpp"
 
-#define TT_EXP_2_SIZE 22 // TT_SIZE is 2^x
-#define BUCKET_SIZE 4
+#define TT_DEFAULT_MB 256 // Default size of the table in megabytes
+#define TT_MIN_MB 1
+#define TT_MAX_MB 65536
+#define BUCKET_SIZE 3
 
 #define NODE_EXACT 0
 #define NODE_UPPERBOUND 1
 #define NODE_LOWERBOUND 2
 
+// Scores and static evals are stored in 16 bits, the caller has to fit them into [-TT_SCORE_MAX, TT_SCORE_MAX]
+#define TT_SCORE_MAX 32000
+#define TT_NO_EVAL INT16_MIN
+#define TT_GENERATION_BITS 6
+
+// The table is allocated on 2 MB boundaries and asks the OS for 2 MB pages, so probes don't keep missing the TLB
+#define TT_LARGE_PAGE_SIZE (C64(2) << 20)
+#define TT_USE_HUGETLB 1 // Try explicitly reserved huge pages (vm.nr_hugepages) before transparent huge pages
+#define TT_CLEAR_CHUNK TT_LARGE_PAGE_SIZE // Each clearing thread zeroes whole large pages
+
+// Saved tables are the header followed by the raw bucket array. The header is padded to 64 KiB, a whole page
+// on 4K, 16K and 64K page kernels alike, so the buckets can be mapped straight from the file
+#define TT_FILE_MAGIC C64(0x31305454414E5554) // "TUNATT01"
+#define TT_FILE_VERSION 3 // Bump whenever TT_entry or bucket changes layout, or the Zobrist keys are generated differently
+#define TT_FILE_HEADER_SIZE (64 << 10)
+
+#define EVAL_CACHE_ENTRIES (1 << 15) // Per search thread, 8 bytes each so the table stays in L2
+
+#define PERFT_TT_DEFAULT_MB 64 // Default size of the perft table in megabytes, 0 turns perft hashing off
+#define PERFT_COUNT_BITS 56 // Node counts share a word with the depth, larger counts aren't stored
+
 
 class HashMove : public Move {
 public:
@@ -29,30 +55,66 @@ public:
 
     bool operator==(Move move);
 
+    const Move to_move() const;
+};
+
+
+struct TT_entry {
+    uint16_t key;
+    // Only the squares, flag and promotion piece of the move (low 16 bits), the search fills in the rest
+    uint16_t move;
+    int16_t score;
+    // A depth of 0 marks an empty entry, stored depths are always at least 1
+    uint8_t depth;
+    // Search generation in the upper TT_GENERATION_BITS, node type in the lower 2 bits
+    uint8_t gen_bound;
+    int16_t static_eval;
+
+    Move get_move() const;
+
     unsigned int get_depth() const;
 
     unsigned int get_node_type() const;
 
-    void set_depth(unsigned int depth);
+    unsigned int get_generation() const;
 
-    void set_node_type(unsigned int node_type);
+    int get_score() const;
 
-    const Move to_move() const;
-};
+    int get_static_eval() const;
 
+    // Everything but the static eval in one word, the way it's stored in a bucket
+    uint64_t get_word() const;
 
-struct TT_entry {
-    unsigned int key;
-    HashMove hash_move;
-    // No need to keep depth info because that's kept in move
-    int score;
-    unsigned int age;
+    static TT_entry from_word(uint64_t word, int16_t static_eval);
 };
 
-struct bucket {
-    TT_entry entries[BUCKET_SIZE];
+// 3 entries fill 30 of the 32 bytes, so a probe only ever touches a single cache line.
+// Everything the search needs to be correct (key, move, score, depth and bound) is kept in a single
+// 64 bit word that is read and written atomically, so threads writing the same entry at once can't
+// tear it and the table needs no locks. The static eval is stored next to it on its own: if it does
+// get mixed up with another position's, only the pruning margins that use it are affected
+struct alignas(32) bucket {
+    std::atomic<uint64_t> words[BUCKET_SIZE];
+    std::atomic<int16_t> static_evals[BUCKET_SIZE];
+    uint16_t padding;
 };
 
+static_assert(sizeof(TT_entry) == 10, "TT entries should be 10 bytes");
+static_assert(offsetof(TT_entry, static_eval) == sizeof(uint64_t), "TT entry word should come first");
+static_assert(sizeof(bucket) == 32, "TT buckets should be 32 bytes");
+
+struct TT_file_header {
+    U64 magic;
+    uint32_t version;
+    uint32_t bucket_bytes;
+    U64 num_buckets;
+    U64 zobrist_seed;
+    U64 header_bytes; // Offset of the bucket array in the file
+    uint8_t generation;
+};
+
+static_assert(sizeof(TT_file_header) <= TT_FILE_HEADER_SIZE, "TT file header should fit in its page");
+
 struct TT_result {
     TT_entry tt_entry;
     bool is_hit;
@@ -61,8 +123,30 @@ struct TT_result {
 class TT {
 private:
     bucket* hash_table;
+    U64 num_buckets;
+    size_t allocated_bytes;
+    size_t page_size;
+    bool huge_pages_requested; // Transparent huge pages were asked for, page_size is still the normal page size
+    unsigned int num_threads; // Threads used to clear the table
+    uint8_t generation;
+
+    void allocate(size_t bytes);
+
+    void deallocate();
+
+    bucket* get_bucket(U64 key) const;
+
+    unsigned int relative_age(const TT_entry& entry) const;
+
+    static TT_entry load_entry(const bucket* b, int index);
+
+    static void store_entry(bucket* b, int index, const TT_entry& entry);
 public:
-    TT();
+    explicit TT(size_t mb = TT_DEFAULT_MB);
+
+    TT(const TT&) = delete;
+
+    TT& operator=(const TT&) = delete;
 
     ~TT();
 
@@ -70,12 +154,93 @@ public:
 
     void prefetch(U64 key) const;
 
-    void set(U64 key, Move best_move, unsigned int depth, unsigned int node_type, int score);
+    void set(U64 key, Move best_move, unsigned int depth, unsigned int node_type, int score,
+             int static_eval = TT_NO_EVAL);
 
-    void increment_age();
+    // Start a new search generation. Entries from earlier generations become the first to be
+    // replaced, their age is worked out in set() so this doesn't have to touch the table
+    void new_search();
 
     void clear();
 
+    // Number of threads clear() splits the table between, normally the search thread count
+    void set_threads(unsigned int threads);
+
+    // Reallocate the table to mb megabytes, discarding its contents
+    // Must not be called while a search is running
+    void resize(size_t mb);
+
+    size_t size_mb() const;
+
+    // Write the table to a file that load() can map back in later
+    // Returns false (and leaves the file incomplete) if it can't be written
+    bool save(const std::string& path) const;
+
+    // Replace the table with one written by save(), taking on its size
+    // The file is mapped copy-on-write, so it's never modified and nothing is copied up front
+    // Returns false and keeps the current table if the file can't be used
+    // Must not be called while a search is running
+    bool load(const std::string& path);
+
+    // Size of the pages backing the table, as far as the OS tells us
+    size_t get_page_size() const;
+
+    // Whether transparent huge pages were requested for the table. The kernel may not have granted all of them
+    bool get_huge_pages_requested() const;
+};
+
+
+// Static evals of recently evaluated positions, so a position evaluated again (by both pruning checks, as
+// a stand pat, or through a transposition) skips the network's output layer
+// Direct mapped and owned by a single search thread, so it needs no atomics
+// An entry is the upper 48 bits of the key with the eval in the lower 16
+class EvalCache {
+private:
+    std::unique_ptr<U64[]> entries;
+public:
+    EvalCache();
+
+    bool probe(U64 key, int& eval) const;
+
+    // Evals that don't fit in 16 bits aren't stored
+    void store(U64 key, int eval);
+
+    // Forget every eval, they're only valid for the network that computed them
+    void clear();
+};
+
+
+// Node counts of perft subtrees, kept apart from the search TT so neither has to give up anything for the other
+// Each entry holds the full key, checked on every probe, so a hit is only ever wrong on a 64 bit Zobrist collision
+// An entry is stored as the count (upper PERFT_COUNT_BITS bits) and depth (lower 8 bits) in one word, and the
+// key XORed with that word in the other. A probe that reads halves written by different threads fails the key
+// check and counts as a miss, so the threads of a split perft can share the table without any locks
+struct alignas(32) perft_bucket {
+    // Entry 0 keeps the deepest subtree, entry 1 always takes the newest
+    std::atomic<U64> checks[2];
+    std::atomic<U64> words[2];
+};
+
+static_assert(sizeof(perft_bucket) == 32, "Perft buckets should be 32 bytes");
+
+class PerftTT {
+private:
+    std::unique_ptr<perft_bucket[]> buckets;
+    U64 num_buckets;
+
+    perft_bucket* get_bucket(U64 key) const;
+public:
+    explicit PerftTT(size_t mb = 0);
+
+    bool probe(U64 key, unsigned int depth, U64& nodes) const;
+
+    // Counts that don't fit in PERFT_COUNT_BITS bits aren't stored
+    void store(U64 key, unsigned int depth, U64 nodes);
+
+    // Reallocate the table to mb megabytes (none for 0), discarding its contents
+    void resize(size_t mb);
+
+    size_t size_mb() const;
 };
 
 
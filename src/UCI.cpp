@@ -10,17 +10,30 @@
 
 UCI::UCI(Thread::SafeQueue<std::vector<std::string>>& c, std::atomic<bool>& b) : cmd_queue(c), should_end_search(b) {};
 
-void init_uci() {
+void init_uci(Thread::SafeQueue<std::vector<std::string>>& cmd_queue) {
     while (true) {
         std::string line;
         std::getline(std::cin, line);
         auto cmd = split(line);
+        if (cmd.empty()) {
+            continue;
+        }
         if (cmd[0] == "isready") {
             return;
         } else if (cmd[0] == "uci") {
-            get_synced_cout().print("id name Bitboard_Chess\n");
-            get_synced_cout().print("id author Andrew_Xia\n");
-            get_synced_cout().print("uciok\n");
+            std::ostringstream buffer;
+            buffer << "id name Bitboard_Chess\n";
+            buffer << "id author Andrew_Xia\n";
+            buffer << "option name Hash type spin default " << TT_DEFAULT_MB
+                   << " min " << TT_MIN_MB << " max " << TT_MAX_MB << '\n';
+            buffer << "option name PerftHash type spin default " << PERFT_TT_DEFAULT_MB
+                   << " min 0 max " << TT_MAX_MB << '\n';
+            buffer << "option name Threads type spin default 1 min 1 max " << MAX_SEARCH_THREADS << '\n';
+            buffer << "option name EvalFile type string default embedded\n";
+            buffer << "uciok\n";
+            get_synced_cout().print(buffer.str());
+        } else if (cmd[0] == "setoption") {
+            cmd_queue.enqueue(cmd);
         }
     }
 }
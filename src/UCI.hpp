@@ -13,8 +13,12 @@
 #include "Thread.hpp"
 #include "Utility.hpp"
 #include "Board.hpp"
+#include "Transposition_table.hpp"
+#include "Search.hpp"
 
-void init_uci();
+// Handles the uci handshake up to the first isready
+// Option commands sent before isready are forwarded to cmd_queue for the engine
+void init_uci(Thread::SafeQueue<std::vector<std::string>>& cmd_queue);
 
 class UCI {
 private:
@@ -11,11 +11,56 @@
 
 #include "depend.hpp"
 
-extern U64 piece_bitstrings[64][2][6];
-extern U64 black_to_move_bitstring;
-extern U64 white_castle_queenside_bitstring, white_castle_kingside_bitstring, black_castle_queenside_bitstring, black_castle_kingside_bitstring;
-extern U64 en_passant_bitstrings[8];
+#include <array>
 
-void init_zobrist_bitstrings();
+#define ZOBRIST_SEED 42 // Keys depend on it, so anything that stores keys (like a saved TT) has to record it
+
+// Keys are drawn from SplitMix64 at compile time, so they're the same with every compiler and standard library
+struct ZobristKeys {
+    U64 pieces[64][2][6];
+    U64 black_to_move;
+    U64 white_castle_queenside, white_castle_kingside, black_castle_queenside, black_castle_kingside;
+    U64 en_passant[8];
+};
+
+constexpr ZobristKeys gen_zobrist_keys() {
+    ZobristKeys keys{};
+    U64 state = ZOBRIST_SEED;
+    auto next = [&state]() {
+        U64 z = (state += C64(0x9E3779B97F4A7C15));
+        z = (z ^ (z >> 30)) * C64(0xBF58476D1CE4E5B9);
+        z = (z ^ (z >> 27)) * C64(0x94D049BB133111EB);
+        return z ^ (z >> 31);
+    };
+
+    for (int i = 0; i < 64; i++) {
+        for (int j = 0; j < 2; j++) {
+            for (int k = 0; k < 6; k++) {
+                keys.pieces[i][j][k] = next();
+            }
+        }
+    }
+    keys.black_to_move = next();
+
+    keys.white_castle_queenside = next();
+    keys.white_castle_kingside = next();
+    keys.black_castle_queenside = next();
+    keys.black_castle_kingside = next();
+
+    for (int i = 0; i < 8; i++) {
+        keys.en_passant[i] = next();
+    }
+    return keys;
+}
+
+inline constexpr ZobristKeys zobrist_keys = gen_zobrist_keys();
+
+inline constexpr auto& piece_bitstrings = zobrist_keys.pieces;
+inline constexpr U64 black_to_move_bitstring = zobrist_keys.black_to_move;
+inline constexpr U64 white_castle_queenside_bitstring = zobrist_keys.white_castle_queenside;
+inline constexpr U64 white_castle_kingside_bitstring = zobrist_keys.white_castle_kingside;
+inline constexpr U64 black_castle_queenside_bitstring = zobrist_keys.black_castle_queenside;
+inline constexpr U64 black_castle_kingside_bitstring = zobrist_keys.black_castle_kingside;
+inline constexpr auto& en_passant_bitstrings = zobrist_keys.en_passant;
 
 #endif /* Zobrist_hpp */
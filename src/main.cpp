@@ -101,12 +101,13 @@ std::string resource_path() {
 
 int main() {
 
-    init_uci();
+    // Synchronization utils
+    Thread::SafeQueue<std::vector<std::string>> cmd_queue;
+    std::atomic<bool> should_end_search(false);
+
+    init_uci(cmd_queue);
 
-    init_bitboard_utils();
     init_eval_utils();
-    init_ray_gen();
-    init_zobrist_bitstrings();
     init_search();
 
 #if USE_BOOK
@@ -115,10 +116,6 @@ int main() {
 
 //    tests();
 
-    // Synchronization utils
-    Thread::SafeQueue<std::vector<std::string>> cmd_queue;
-    std::atomic<bool> should_end_search(false);
-
     Engine engine(cmd_queue, should_end_search);
     UCI uci(cmd_queue, should_end_search);
 
@@ -12,6 +12,7 @@
 #include "src/Data_structs.hpp"
 #include <iostream>
 #include <string>
+#include <vector>
 
 // Counter for mismatches
 int mismatches = 0;
@@ -25,7 +26,7 @@ long perft_nnue_test(Board& board, unsigned int depth) {
         // Compare incremental eval with from-scratch eval
         auto* acc = board.get_nnue_accumulator();
         if (NNUE::is_loaded() && acc) {
-            int incremental_eval = NNUE::evaluate_incremental(*acc, board.get_current_turn());
+            int incremental_eval = NNUE::evaluate_incremental(*acc, board.get_current_turn(), NNUE::output_bucket(board));
             int from_scratch_eval = NNUE::evaluate(board);
             
             if (incremental_eval != from_scratch_eval) {
@@ -62,13 +63,35 @@ long perft_nnue_test(Board& board, unsigned int depth) {
     return nodes;
 }
 
-int main() {
+// Check evaluate_positions against evaluate on the position and every position one move away from it
+// The table is shared between test positions, so the first board of each batch has nothing in common with it
+int batch_test(Board& board, NNUE::RefreshTable& table) {
+    std::vector<Board> boards(1, board);
+    MoveList moves;
+    board.generate_moves(moves);
+    for (auto it = moves.begin(); it != moves.end(); ++it) {
+        board.make_move(*it);
+        boards.push_back(board);
+        board.unmake_move();
+    }
+
+    std::vector<int> evals(boards.size());
+    NNUE::evaluate_positions(boards.data(), static_cast<int>(boards.size()), evals.data(), table);
+    int batch_mismatches = 0;
+    for (size_t i = 0; i < boards.size(); i++) {
+        if (evals[i] != NNUE::evaluate(boards[i])) {
+            batch_mismatches++;
+        }
+    }
+    return batch_mismatches;
+}
+
+int main(int argc, char** argv) {
     // Initialize evaluation utilities
     init_eval_utils();
-    init_bitboard_utils();
     
-    // Load NNUE network
-    std::string nnue_path = "NNUE/checkpoints/tuna-100/quantised.bin";
+    // Load NNUE network, any network file can be passed to check other layouts
+    std::string nnue_path = argc > 1 ? argv[1] : "NNUE/checkpoints/tuna-100/quantised.bin";
     
     std::cout << "Loading NNUE network from: " << nnue_path << std::endl;
     
@@ -99,6 +122,7 @@ int main() {
     std::cout << std::string(80, '=') << std::endl;
     
     bool all_passed = true;
+    NNUE::RefreshTable batch_table;
     
     for (const auto& test : positions) {
         mismatches = 0;
@@ -112,9 +136,14 @@ int main() {
         board.refresh_nnue_accumulator();  // Refresh after network is loaded
         
         long nodes = perft_nnue_test(board, test.depth);
+        int batch_mismatches = batch_test(board, batch_table);
+        mismatches += batch_mismatches;
         
         std::cout << "Nodes: " << nodes << std::endl;
         std::cout << "Nodes tested: " << nodes_tested << std::endl;
+        if (batch_mismatches) {
+            std::cout << "Batch evaluation mismatches: " << batch_mismatches << std::endl;
+        }
         
         if (mismatches == 0) {
             std::cout << "✓ PASSED - All evaluations match!" << std::endl;